@@ -7,6 +7,7 @@
 QT       += core gui
 QT       += serialport
 QT       += charts
+QT       += concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -27,18 +28,54 @@ DEFINES += QT_DEPRECATED_WARNINGS
 CONFIG += c++11
 
 SOURCES += \
+        axisautoscaler.cpp \
+        captureanalysis.cpp \
+        captureanalyzer.cpp \
+        compressedhistory.cpp \
+        deltaframe.cpp \
+        framecodec.cpp \
+        historychartview.cpp \
+        historyexporter.cpp \
         main.cpp \
+        minmaxindex.cpp \
+        nativeserialport.cpp \
+        rolluptiers.cpp \
+        sampleclock.cpp \
+        samplefilters.cpp \
+        sessionjournal.cpp \
         settingsdialog.cpp \
+        sharedmemorypublisher.cpp \
+        taggedframe.cpp \
         temperature_data_display.cpp
 
 HEADERS += \
+        axisautoscaler.h \
+        captureanalysis.h \
+        captureanalyzer.h \
+        compressedhistory.h \
+        deltaframe.h \
+        framecodec.h \
+        historychartview.h \
+        historyexporter.h \
+        minmaxindex.h \
+        nativeserialport.h \
+        rolluptiers.h \
+        sampleclock.h \
+        samplefilters.h \
+        sampleshmring.h \
+        sessionjournal.h \
         settingsdialog.h \
+        sharedmemorypublisher.h \
+        taggedframe.h \
         temperature_data_display.h
 
 FORMS += \
         settingsdialog.ui \
         temperature_data_display.ui
 
+# shm_open lives in librt on older glibc
+unix:!macx: LIBS += -lrt
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
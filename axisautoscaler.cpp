@@ -0,0 +1,72 @@
+#include "axisautoscaler.h"
+
+#include <cmath>
+
+void SlidingMinMax::clear()
+{
+    m_min.resize(0);
+    m_max.resize(0);
+    m_minHead = 0;
+    m_maxHead = 0;
+}
+
+void SlidingMinMax::popFront(QVector<Entry> &deque, int &head)
+{
+    head++;
+    if (head == deque.size()) {
+        deque.resize(0);
+        head = 0;
+    } else if (head >= 64 && head * 2 >= deque.size()) {
+        deque.remove(0, head);
+        head = 0;
+    }
+}
+
+void SlidingMinMax::push(qint64 timeNs, double value)
+{
+    while (m_min.size() > m_minHead && m_min.last().value >= value)
+        m_min.removeLast();
+    m_min.append(Entry{timeNs, value});
+    while (m_max.size() > m_maxHead && m_max.last().value <= value)
+        m_max.removeLast();
+    m_max.append(Entry{timeNs, value});
+}
+
+void SlidingMinMax::expire(qint64 fromNs)
+{
+    while (m_minHead < m_min.size() && m_min.at(m_minHead).timeNs < fromNs)
+        popFront(m_min, m_minHead);
+    while (m_maxHead < m_max.size() && m_max.at(m_maxHead).timeNs < fromNs)
+        popFront(m_max, m_maxHead);
+}
+
+bool AxisAutoscaler::update(double dataMin, double dataMax, qint64 nowNs, double &low, double &high)
+{
+    //Pad the data, then round out to a step of about a tenth of the span so small moves in the
+    //data mostly land on the same range
+    const double span = qMax(dataMax - dataMin, 0.0);
+    const double pad = qMax(span * m_padding, (m_minimumSpan - span) / 2);
+    const double step = std::pow(10.0, std::floor(std::log10(span + 2 * pad)) - 1);
+    const double targetLow = std::floor((dataMin - pad) / step) * step;
+    const double targetHigh = std::ceil((dataMax + pad) / step) * step;
+
+    bool change;
+    if (!m_valid || dataMin < m_low || dataMax > m_high) {
+        change = true;
+    } else {
+        //Only shrink for a real difference, and not more often than the minimum interval
+        const double current = m_high - m_low;
+        change = (targetHigh - targetLow) < 0.75 * current
+                && nowNs - m_changedNs >= m_minimumIntervalNs;
+    }
+    if (!change || (m_valid && targetLow == m_low && targetHigh == m_high))
+        return false;
+
+    m_valid = true;
+    m_low = targetLow;
+    m_high = targetHigh;
+    m_changedNs = nowNs;
+    low = m_low;
+    high = m_high;
+    return true;
+}
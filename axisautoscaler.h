@@ -0,0 +1,70 @@
+/*
+ * Purpose: Y axis autoscaling for the live chart.
+ *
+ * SlidingMinMax tracks the min and max of samples inside a window that slides forward in time,
+ * with the usual pair of monotonic deques: a sample that can never again be the max (an older
+ * one no bigger than a newer one) is dropped when the newer one arrives, and samples fall off
+ * the front as they leave the window. Each sample is pushed and popped at most once, so keeping
+ * the bounds current is O(1) amortised however many points are on screen.
+ *
+ * AxisAutoscaler turns those bounds into an axis range: padded, rounded out to a tidy step and
+ * rate limited. Growing happens straight away so no reading is drawn off the chart, shrinking
+ * only when the range would lose a good part of its span and the last change was long enough ago.
+ * */
+
+#ifndef AXISAUTOSCALER_H
+#define AXISAUTOSCALER_H
+
+#include <QVector>
+#include <QtGlobal>
+
+class SlidingMinMax
+{
+public:
+    void clear();
+    //timeNs must not go backwards
+    void push(qint64 timeNs, double value);
+    //Forgets samples older than fromNs
+    void expire(qint64 fromNs);
+
+    bool isEmpty() const { return m_maxHead == m_max.size(); }
+    double min() const { return m_min.at(m_minHead).value; }
+    double max() const { return m_max.at(m_maxHead).value; }
+
+private:
+    struct Entry { qint64 timeNs; double value; };
+    //A deque as a vector with a moving head, compacted once the dead front is half of it
+    static void popFront(QVector<Entry> &deque, int &head);
+
+    QVector<Entry> m_min;   //Values rise from the head
+    QVector<Entry> m_max;   //Values fall from the head
+    int m_minHead = 0;
+    int m_maxHead = 0;
+};
+
+class AxisAutoscaler
+{
+public:
+    //Padding is a fraction of the data span added above and below
+    void setPadding(double fraction) { m_padding = fraction; }
+    double padding() const { return m_padding; }
+    //Narrowest range shown, so one LSB of noise does not fill the chart
+    void setMinimumSpan(double span) { m_minimumSpan = span; }
+    void setMinimumIntervalNs(qint64 ns) { m_minimumIntervalNs = ns; }
+    //Next update() picks a range from scratch, e.g. after the view jumped
+    void reset() { m_valid = false; }
+
+    //Returns true with the new range in low/high when the axis should change
+    bool update(double dataMin, double dataMax, qint64 nowNs, double &low, double &high);
+
+private:
+    double m_padding = 0.1;
+    double m_minimumSpan = 0.5;
+    qint64 m_minimumIntervalNs = 500000000LL;
+    bool m_valid = false;
+    double m_low = 0;
+    double m_high = 0;
+    qint64 m_changedNs = 0;
+};
+
+#endif // AXISAUTOSCALER_H
@@ -0,0 +1,237 @@
+#include "captureanalysis.h"
+#include "historyexporter.h"
+
+#include <QDateTime>
+#include <QtEndian>
+
+#include <cmath>
+#include <cstring>
+
+double IntervalStats::stddev() const
+{
+    if (count < 2)
+        return 0;
+    const double m = mean();
+    return std::sqrt(qMax(sumSquares / count - m * m, 0.0));
+}
+
+bool CaptureAnalysis::splitCapture(const uchar *data, qint64 size, QVector<CaptureUnit> &units,
+                                   quint64 &samples, QString &error)
+{
+    units.resize(0);
+    samples = 0;
+    if (size < 8 || qFromLittleEndian<quint32>(data) != ColumnarFileMagic) {
+        error = QStringLiteral("not a columnar capture");
+        return false;
+    }
+    if (qFromLittleEndian<quint32>(data + 4) != ColumnarFileVersion) {
+        error = QStringLiteral("unsupported capture version");
+        return false;
+    }
+
+    //Only the chunk headers are read here, the columns are left to the workers
+    qint64 pos = 8;
+    while (pos < size) {
+        if (size - pos < 4) {
+            error = QStringLiteral("capture is cut short");
+            return false;
+        }
+        const qint64 count = qFromLittleEndian<quint32>(data + pos);
+        pos += 4;
+        if (size - pos < count * 16) {
+            error = QStringLiteral("capture is cut short");
+            return false;
+        }
+        //Big chunks from other writers are split too, so every thread gets a fair share
+        for (qint64 first = 0; first < count; first += MaxUnitSamples) {
+            units.append(CaptureUnit{pos + first * 8, pos + count * 8 + first * 8,
+                                     int(qMin(qint64(MaxUnitSamples), count - first))});
+        }
+        pos += count * 16;
+        samples += quint64(count);
+    }
+    return true;
+}
+
+static inline qint64 intervalStart(qint64 timeNs, qint64 widthNs)
+{
+    const qint64 r = timeNs % widthNs;
+    return timeNs - (r < 0 ? r + widthNs : r);
+}
+
+UnitResult CaptureAnalysis::analyzeUnit(const uchar *data, const CaptureUnit &unit, const AnalysisOptions &options)
+{
+    UnitResult result;
+    result.count = quint64(unit.count);
+    result.histogram.fill(0, options.binCount());
+    const uchar *times = data + unit.timesOffset;
+    const uchar *values = data + unit.valuesOffset;
+    const int bins = result.histogram.size();
+    quint64 *histogram = result.histogram.data();
+
+    qint64 previousNs = 0;
+    bool excursion = false;
+    for (int i = 0; i < unit.count; i++) {
+        const qint64 timeNs = qFromLittleEndian<qint64>(times + 8 * i);
+        const quint64 bits = qFromLittleEndian<quint64>(values + 8 * i);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+
+        if (i == 0)
+            result.firstNs = timeNs;
+        else if (timeNs - previousNs > options.gapNs)
+            result.gaps.append(Gap{previousNs, timeNs});
+        previousNs = timeNs;
+
+        const qint64 start = intervalStart(timeNs, options.intervalNs);
+        if (result.intervals.isEmpty() || result.intervals.last().startNs != start)
+            result.intervals.append(IntervalStats{start, value, value, 0, 0, 0});
+        IntervalStats &interval = result.intervals.last();
+        interval.min = qMin(interval.min, value);
+        interval.max = qMax(interval.max, value);
+        interval.sum += value;
+        interval.sumSquares += value * value;
+        interval.count++;
+
+        //Clamped while still a double, converting an out of range or NaN bin to int is undefined
+        if (std::isfinite(value)) {
+            const double bin = std::floor((value - options.histogramLow) / options.binWidth);
+            histogram[int(qBound(0.0, bin, double(bins - 1)))]++;
+        }
+
+        const bool above = value > options.highThreshold;
+        if (above || value < options.lowThreshold) {
+            if (excursion && result.excursions.last().above == above) {
+                Excursion &e = result.excursions.last();
+                e.endNs = timeNs;
+                e.peak = above ? qMax(e.peak, value) : qMin(e.peak, value);
+            } else {
+                result.excursions.append(Excursion{timeNs, timeNs, value, above});
+            }
+            excursion = true;
+        } else {
+            excursion = false;
+        }
+    }
+    result.lastNs = previousNs;
+    return result;
+}
+
+void CaptureReport::reset(const AnalysisOptions &options)
+{
+    m_options = options;
+    m_count = 0;
+    m_firstNs = 0;
+    m_lastNs = 0;
+    m_intervals.resize(0);
+    m_excursions.resize(0);
+    m_gaps.resize(0);
+    m_histogram.fill(0, options.binCount());
+}
+
+void CaptureReport::merge(const UnitResult &result)
+{
+    if (result.count == 0)
+        return;
+
+    int first = 0;
+    if (m_count == 0) {
+        m_firstNs = result.firstNs;
+    } else {
+        if (result.firstNs - m_lastNs > m_options.gapNs)
+            m_gaps.append(Gap{m_lastNs, result.firstNs});
+        //An interval cut by the unit boundary
+        if (!result.intervals.isEmpty() && result.intervals.first().startNs == m_intervals.last().startNs) {
+            IntervalStats &into = m_intervals.last();
+            const IntervalStats &from = result.intervals.first();
+            into.min = qMin(into.min, from.min);
+            into.max = qMax(into.max, from.max);
+            into.sum += from.sum;
+            into.sumSquares += from.sumSquares;
+            into.count += from.count;
+            first = 1;
+        }
+    }
+    for (int i = first; i < result.intervals.size(); i++)
+        m_intervals.append(result.intervals.at(i));
+
+    //An excursion still running at the end of the last unit carries on into this one
+    first = 0;
+    if (!result.excursions.isEmpty() && !m_excursions.isEmpty()) {
+        Excursion &last = m_excursions.last();
+        const Excursion &next = result.excursions.first();
+        if (last.endNs == m_lastNs && next.startNs == result.firstNs && last.above == next.above) {
+            last.endNs = next.endNs;
+            last.peak = last.above ? qMax(last.peak, next.peak) : qMin(last.peak, next.peak);
+            first = 1;
+        }
+    }
+    for (int i = first; i < result.excursions.size(); i++)
+        m_excursions.append(result.excursions.at(i));
+
+    m_gaps += result.gaps;
+    for (int i = 0; i < m_histogram.size() && i < result.histogram.size(); i++)
+        m_histogram[i] += result.histogram.at(i);
+    m_count += result.count;
+    m_lastNs = result.lastNs;
+}
+
+static QString timeText(qint64 timeNs)
+{
+    return QDateTime::fromMSecsSinceEpoch(timeNs / 1000000).toString(QStringLiteral("yyyy-MM-dd hh:mm:ss.zzz"));
+}
+
+QString CaptureReport::toText(int maxRows) const
+{
+    QString text;
+    if (m_count == 0)
+        return QStringLiteral("No readings yet\n");
+
+    double min = m_intervals.first().min, max = m_intervals.first().max, sum = 0;
+    for (const IntervalStats &s : m_intervals) {
+        min = qMin(min, s.min);
+        max = qMax(max, s.max);
+        sum += s.sum;
+    }
+    text += QStringLiteral("%1 readings, %2 to %3\n").arg(m_count).arg(timeText(m_firstNs)).arg(timeText(m_lastNs));
+    text += QStringLiteral("min %1 C, max %2 C, mean %3 C\n\n")
+            .arg(min, 0, 'f', 3).arg(max, 0, 'f', 3).arg(sum / m_count, 0, 'f', 3);
+
+    text += QStringLiteral("Excursions above %1 C or below %2 C: %3\n")
+            .arg(m_options.highThreshold).arg(m_options.lowThreshold).arg(m_excursions.size());
+    for (int i = 0; i < m_excursions.size() && i < maxRows; i++) {
+        const Excursion &e = m_excursions.at(i);
+        text += QStringLiteral("  %1  %2 s  %3 %4 C\n").arg(timeText(e.startNs))
+                .arg((e.endNs - e.startNs) / 1e9, 0, 'f', 1)
+                .arg(e.above ? QStringLiteral("peak") : QStringLiteral("low")).arg(e.peak, 0, 'f', 3);
+    }
+
+    text += QStringLiteral("\nGaps over %1 s: %2\n").arg(m_options.gapNs / 1e9).arg(m_gaps.size());
+    for (int i = 0; i < m_gaps.size() && i < maxRows; i++) {
+        const Gap &g = m_gaps.at(i);
+        text += QStringLiteral("  %1  %2 s\n").arg(timeText(g.fromNs)).arg((g.toNs - g.fromNs) / 1e9, 0, 'f', 1);
+    }
+
+    text += QStringLiteral("\nHistogram, %1 C bins:\n").arg(m_options.binWidth);
+    quint64 peak = 0;
+    for (quint64 n : m_histogram)
+        peak = qMax(peak, n);
+    for (int i = 0; i < m_histogram.size(); i++) {
+        if (!m_histogram.at(i))
+            continue;
+        text += QStringLiteral("  %1  %2 %3\n").arg(m_options.histogramLow + i * m_options.binWidth, 7, 'f', 2)
+                .arg(QString(int(40 * m_histogram.at(i) / peak) + 1, QLatin1Char('#')), -41).arg(m_histogram.at(i));
+    }
+
+    text += QStringLiteral("\n%1 intervals of %2 s (min, max, mean, stddev, readings):\n")
+            .arg(m_intervals.size()).arg(m_options.intervalNs / 1e9);
+    for (int i = 0; i < m_intervals.size() && i < maxRows; i++) {
+        const IntervalStats &s = m_intervals.at(i);
+        text += QStringLiteral("  %1  %2  %3  %4  %5  %6\n").arg(timeText(s.startNs))
+                .arg(s.min, 0, 'f', 3).arg(s.max, 0, 'f', 3).arg(s.mean(), 0, 'f', 3)
+                .arg(s.stddev(), 0, 'f', 3).arg(s.count);
+    }
+    if (m_intervals.size() > maxRows)
+        text += QStringLiteral("  ...\n");
+    return text;
+}
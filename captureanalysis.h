@@ -0,0 +1,121 @@
+/*
+ * Purpose: Offline analysis of a columnar capture (.tgc, see historyexporter.h), split into work
+ * units that are analysed independently and merged in file order:
+ *
+ *   per-interval stats   min/max/mean/stddev for each interval, aligned to multiples of its width
+ *   excursions           runs of readings above the high or below the low threshold
+ *   histogram            fixed width bins over the sensor's range, clamped at the ends
+ *   gaps                 stretches longer than the gap threshold with no reading
+ *
+ * analyzeUnit() is the map step and touches nothing but its own slice of the file, so units run
+ * on as many threads as there are. CaptureReport::merge() is the reduce step. It must see the
+ * units in order, because excursions and gaps can straddle unit boundaries.
+ * */
+
+#ifndef CAPTUREANALYSIS_H
+#define CAPTUREANALYSIS_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+struct AnalysisOptions
+{
+    qint64 intervalNs = 60 * 1000000000LL;
+    double lowThreshold = 10;
+    double highThreshold = 45;
+    qint64 gapNs = 5 * 1000000000LL;
+    double histogramLow = -40;      //ADT7420 range
+    double histogramHigh = 150;
+    double binWidth = 0.5;
+
+    int binCount() const { return qMax(1, int((histogramHigh - histogramLow) / binWidth)); }
+};
+
+//A slice of one chunk of the file, at most MaxUnitSamples readings
+struct CaptureUnit
+{
+    qint64 timesOffset;
+    qint64 valuesOffset;
+    int count;
+};
+
+struct IntervalStats
+{
+    qint64 startNs;
+    double min;
+    double max;
+    double sum;
+    double sumSquares;
+    quint64 count;
+
+    double mean() const { return count ? sum / count : 0; }
+    double stddev() const;
+};
+
+struct Excursion
+{
+    qint64 startNs;     //First and last reading past the threshold
+    qint64 endNs;
+    double peak;        //Furthest reading from the band
+    bool above;
+};
+
+struct Gap
+{
+    qint64 fromNs;
+    qint64 toNs;
+};
+
+struct UnitResult
+{
+    int unit = -1;
+    quint64 count = 0;
+    qint64 firstNs = 0;
+    qint64 lastNs = 0;
+    QVector<IntervalStats> intervals;
+    QVector<Excursion> excursions;
+    QVector<Gap> gaps;
+    QVector<quint64> histogram;
+};
+
+namespace CaptureAnalysis {
+static const int MaxUnitSamples = 65536;
+
+//Checks the header and lists the work units of a capture held in memory (usually mapped).
+//Returns false with error set if it is not a columnar capture or is cut short.
+bool splitCapture(const uchar *data, qint64 size, QVector<CaptureUnit> &units, quint64 &samples, QString &error);
+
+UnitResult analyzeUnit(const uchar *data, const CaptureUnit &unit, const AnalysisOptions &options);
+}
+
+class CaptureReport
+{
+public:
+    void reset(const AnalysisOptions &options);
+    //result must be the next unit in file order
+    void merge(const UnitResult &result);
+
+    quint64 count() const { return m_count; }
+    qint64 firstNs() const { return m_firstNs; }
+    qint64 lastNs() const { return m_lastNs; }
+    const QVector<IntervalStats> &intervals() const { return m_intervals; }
+    const QVector<Excursion> &excursions() const { return m_excursions; }
+    const QVector<Gap> &gaps() const { return m_gaps; }
+    const QVector<quint64> &histogram() const { return m_histogram; }
+
+    //Plain text summary, with at most maxRows rows of each list
+    QString toText(int maxRows) const;
+
+private:
+    AnalysisOptions m_options;
+    quint64 m_count = 0;
+    qint64 m_firstNs = 0;
+    qint64 m_lastNs = 0;
+    QVector<IntervalStats> m_intervals;
+    QVector<Excursion> m_excursions;
+    QVector<Gap> m_gaps;
+    QVector<quint64> m_histogram;
+};
+
+#endif // CAPTUREANALYSIS_H
@@ -0,0 +1,110 @@
+#include "captureanalyzer.h"
+
+#include <QThreadPool>
+#include <QtConcurrent>
+
+CaptureAnalyzer::CaptureAnalyzer(QObject *parent) : QObject(parent)
+{
+    connect(&m_watcher, &QFutureWatcher<UnitResult>::resultReadyAt, this, &CaptureAnalyzer::unitReady);
+    connect(&m_watcher, &QFutureWatcher<UnitResult>::finished, this, &CaptureAnalyzer::mapFinished);
+}
+
+CaptureAnalyzer::~CaptureAnalyzer()
+{
+    //The workers read straight out of the mapping, it has to outlive them
+    m_watcher.cancel();
+    m_watcher.waitForFinished();
+    release();
+}
+
+UnitResult CaptureAnalyzer::AnalyzeUnit::operator()(int index) const
+{
+    UnitResult result = CaptureAnalysis::analyzeUnit(data, units[index], options);
+    result.unit = index;
+    return result;
+}
+
+bool CaptureAnalyzer::start(const QString &fileName, const AnalysisOptions &options)
+{
+    if (m_running) {
+        m_errorString = tr("An analysis is already running");
+        return false;
+    }
+    release();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    const qint64 size = m_file.size();
+    m_data = size > 0 ? m_file.map(0, size) : nullptr;
+    if (!m_data) {
+        m_buffer = m_file.readAll();
+        m_data = reinterpret_cast<const uchar *>(m_buffer.constData());
+    }
+
+    QString error;
+    if (!CaptureAnalysis::splitCapture(m_data, size, m_units, m_samples, error)) {
+        m_errorString = error;
+        release();
+        return false;
+    }
+
+    m_indexes.resize(m_units.size());
+    for (int i = 0; i < m_indexes.size(); i++)
+        m_indexes[i] = i;
+    m_ready.fill(false, m_units.size());
+    m_merged = 0;
+    m_report.reset(options);
+    m_elapsed.start();
+    m_lastUpdate.start();
+    m_running = true;
+    m_watcher.setFuture(QtConcurrent::mapped(m_indexes, AnalyzeUnit{m_data, m_units.constData(), options}));
+    return true;
+}
+
+void CaptureAnalyzer::cancel()
+{
+    m_watcher.cancel();
+}
+
+void CaptureAnalyzer::unitReady(int index)
+{
+    m_ready[index] = true;
+    const int before = m_merged;
+    while (m_merged < m_ready.size() && m_ready.at(m_merged)) {
+        m_report.merge(m_watcher.resultAt(m_merged));
+        m_merged++;
+    }
+    if (m_merged != before && m_lastUpdate.elapsed() >= 100) {
+        m_lastUpdate.restart();
+        emit updated(m_merged, m_units.size());
+    }
+}
+
+void CaptureAnalyzer::mapFinished()
+{
+    const qint64 ms = m_elapsed.elapsed();
+    const bool complete = m_merged == m_units.size();
+    release();
+    m_running = false;
+    emit updated(m_merged, m_units.size());
+    if (complete) {
+        emit finished(true, tr("Analysed %1 readings in %2 ms on %3 threads")
+                      .arg(m_samples).arg(ms).arg(QThreadPool::globalInstance()->maxThreadCount()));
+    } else {
+        emit finished(false, tr("Analysis cancelled after %1 of %2 units").arg(m_merged).arg(m_units.size()));
+    }
+}
+
+void CaptureAnalyzer::release()
+{
+    if (m_file.isOpen()) {
+        if (m_buffer.isEmpty() && m_data)
+            m_file.unmap(const_cast<uchar *>(m_data));
+        m_file.close();
+    }
+    m_buffer.clear();
+    m_data = nullptr;
+}
@@ -0,0 +1,79 @@
+/*
+ * Purpose: Runs the capture analysis (captureanalysis.h) over a whole .tgc file on the global
+ * thread pool. The file is mapped rather than read, so the workers share the page cache and
+ * each only touches its own units. Results come back in whatever order the threads finish and
+ * are merged on the GUI thread as soon as every unit before them is in, so the report grows
+ * from the start of the capture while the rest is still being worked on.
+ * */
+
+#ifndef CAPTUREANALYZER_H
+#define CAPTUREANALYZER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QVector>
+
+#include "captureanalysis.h"
+
+class CaptureAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CaptureAnalyzer(QObject *parent = nullptr);
+    ~CaptureAnalyzer();
+
+    //False with errorString() set if the file can't be opened or isn't a capture, or if a run
+    //is still going (wait for finished(), cancel() first if need be)
+    bool start(const QString &fileName, const AnalysisOptions &options);
+    //Units already running finish, the rest are dropped
+    void cancel();
+    bool isRunning() const { return m_running; }
+    QString errorString() const { return m_errorString; }
+
+    const CaptureReport &report() const { return m_report; }
+    quint64 samples() const { return m_samples; }
+
+signals:
+    //The report has grown, at most every 100 ms and once more at the end
+    void updated(int doneUnits, int totalUnits);
+    void finished(bool ok, const QString &message);
+
+private slots:
+    void unitReady(int index);
+    void mapFinished();
+
+private:
+    //Map step, copied to every worker
+    struct AnalyzeUnit {
+        typedef UnitResult result_type;
+        const uchar *data;
+        const CaptureUnit *units;
+        AnalysisOptions options;
+        UnitResult operator()(int index) const;
+    };
+
+    void release();
+
+    QFile m_file;
+    QByteArray m_buffer;            //Holds the file when it can't be mapped
+    const uchar *m_data = nullptr;
+    QVector<CaptureUnit> m_units;
+    QVector<int> m_indexes;
+    QVector<bool> m_ready;
+    int m_merged = 0;               //Units 0..m_merged-1 are in the report
+    quint64 m_samples = 0;
+    CaptureReport m_report;
+    QFutureWatcher<UnitResult> m_watcher;
+    //From start() until finished() is emitted. The watcher stops running before its queued
+    //results and finished signal are delivered, and those still use the run's mapping.
+    bool m_running = false;
+    QElapsedTimer m_elapsed;
+    QElapsedTimer m_lastUpdate;
+    QString m_errorString;
+};
+
+#endif // CAPTUREANALYZER_H
@@ -0,0 +1,496 @@
+#include "compressedhistory.h"
+
+#include <QDataStream>
+#include <QIODevice>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const quint32 HistoryFileMagic = 0x54474842; //"TGHB"
+static const quint32 HistoryFileVersion = 1;
+
+static inline quint64 doubleBits(double v)
+{
+    quint64 bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static inline double bitsDouble(quint64 bits)
+{
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static inline qint64 signExtend(quint64 bits, int count)
+{
+    const quint64 sign = quint64(1) << (count - 1);
+    return qint64((bits ^ sign) - sign);
+}
+
+static inline bool fitsSigned(qint64 v, int count)
+{
+    const qint64 limit = qint64(1) << (count - 1);
+    return v >= -limit && v < limit;
+}
+
+static inline int leadingZeros(quint64 v)
+{
+    return v ? __builtin_clzll(v) : 64;
+}
+
+static inline int trailingZeros(quint64 v)
+{
+    return v ? __builtin_ctzll(v) : 64;
+}
+
+//Fewest and most bits a sample can take: a zero time and value bit, or the widest time
+//bucket plus the widest value encoding (Xor with a new window)
+static const int MinSampleBits = 2;
+static const int MaxSampleBits = 5 + 64 + 2 + 5 + 6 + 64;
+
+static inline qint64 floorDiv1000(qint64 v)
+{
+    return v >= 0 ? v / 1000 : -((-v + 999) / 1000);
+}
+
+void BitWriter::write(quint64 bits, int count)
+{
+    while (count > 0) {
+        const int take = qMin(count, 56 - m_pending);
+        const quint64 chunk = (bits >> (count - take)) & ((quint64(1) << take) - 1);
+        m_acc = (m_acc << take) | chunk;
+        m_pending += take;
+        count -= take;
+        while (m_pending >= 8) {
+            m_pending -= 8;
+            m_data.append(char((m_acc >> m_pending) & 0xFF));
+        }
+    }
+}
+
+QByteArray BitWriter::bytes() const
+{
+    QByteArray out = m_data;
+    if (m_pending > 0)
+        out.append(char((m_acc << (8 - m_pending)) & 0xFF));
+    return out;
+}
+
+void BitWriter::clear()
+{
+    m_data = QByteArray();
+    m_acc = 0;
+    m_pending = 0;
+}
+
+void BitReader::refill()
+{
+    while (m_available <= 56) {
+        m_acc <<= 8;
+        if (m_data < m_end)
+            m_acc |= *m_data++;
+        m_available += 8;
+    }
+}
+
+quint64 BitReader::read(int count)
+{
+    quint64 out = 0;
+    while (count > 0) {
+        if (m_available < count)
+            refill();
+        const int take = qMin(count, m_available);
+        const quint64 mask = take == 64 ? ~quint64(0) : ((quint64(1) << take) - 1);
+        out = (take == 64 ? 0 : (out << take)) | ((m_acc >> (m_available - take)) & mask);
+        m_available -= take;
+        count -= take;
+    }
+    return out;
+}
+
+CompressedHistory::CompressedHistory(ValueEncoding encoding, double quantum, int blockCapacity) :
+    m_encoding(encoding), m_quantum(quantum), m_blockCapacity(qMax(2, blockCapacity))
+{
+}
+
+void CompressedHistory::clear()
+{
+    m_sealed.clear();
+    m_index.clear();
+    m_sealedCount = 0;
+    m_sealedBytes = 0;
+    m_open = CompressedBlock();
+    m_writer.clear();
+}
+
+qint64 CompressedHistory::firstTimeNs() const
+{
+    if (!m_sealed.isEmpty())
+        return m_sealed.first().firstTimeNs;
+    return m_open.firstTimeNs;
+}
+
+qint64 CompressedHistory::lastTimeNs() const
+{
+    if (m_open.count)
+        return m_open.lastTimeNs;
+    return m_sealed.isEmpty() ? 0 : m_sealed.last().lastTimeNs;
+}
+
+qint64 CompressedHistory::byteSize() const
+{
+    return m_sealedBytes + (m_writer.bitCount() + 7) / 8;
+}
+
+CompressedBlock CompressedHistory::blockAt(int i) const
+{
+    if (i < m_sealed.size())
+        return m_sealed.at(i);
+    CompressedBlock open = m_open;
+    open.data = m_writer.bytes();
+    return open;
+}
+
+int CompressedHistory::firstBlockEndingAfter(qint64 timeNs) const
+{
+    const auto it = std::lower_bound(m_sealed.begin(), m_sealed.end(), timeNs,
+                                     [](const CompressedBlock &b, qint64 t) { return b.lastTimeNs < t; });
+    int i = int(it - m_sealed.begin());
+    if (i == m_sealed.size() && m_open.count && m_open.lastTimeNs < timeNs)
+        i++;
+    return i;
+}
+
+bool CompressedHistory::minMaxInRange(qint64 fromNs, qint64 toNs, double &min, double &max) const
+{
+    const int total = blockTotal();
+    const int first = firstBlockEndingAfter(fromNs);
+    //Last block starting at or before toNs
+    const auto it = std::upper_bound(m_sealed.begin(), m_sealed.end(), toNs,
+                                     [](qint64 t, const CompressedBlock &b) { return t < b.firstTimeNs; });
+    int last = int(it - m_sealed.begin()) - 1;
+    if (m_open.count && m_open.firstTimeNs <= toNs)
+        last = m_sealed.size();
+    if (first >= total || last < first)
+        return false;
+
+    bool found = false;
+    min = 0;
+    max = 0;
+    auto merge = [&](double lo, double hi) {
+        min = found ? qMin(min, lo) : lo;
+        max = found ? qMax(max, hi) : hi;
+        found = true;
+    };
+    auto edge = [&](int i) {
+        const CompressedBlock block = blockAt(i);
+        if (block.firstTimeNs >= fromNs && block.lastTimeNs <= toNs) {
+            merge(block.minValue, block.maxValue);
+            return;
+        }
+        decodeBlock(block, [&](qint64 t, double v) {
+            if (t >= fromNs && t <= toNs)
+                merge(v, v);
+        });
+    };
+
+    edge(first);
+    if (last > first) {
+        if (last > first + 1) {
+            double lo, hi;
+            m_index.query(first + 1, last - 1, lo, hi);
+            merge(lo, hi);
+        }
+        edge(last);
+    }
+    return found;
+}
+
+QVector<CompressedBlock> CompressedHistory::blocks() const
+{
+    QVector<CompressedBlock> out = m_sealed;
+    if (m_open.count) {
+        CompressedBlock open = m_open;
+        open.data = m_writer.bytes();
+        out.append(open);
+    }
+    return out;
+}
+
+void CompressedHistory::append(qint64 timeNs, double value)
+{
+    //Time must not run backwards inside the history
+    if (count() > 0 && timeNs < lastTimeNs())
+        timeNs = lastTimeNs();
+    const qint64 timeUs = floorDiv1000(timeNs);
+
+    if (m_open.count == 0) {
+        m_open.firstTimeNs = timeUs * 1000;
+        m_open.minValue = value;
+        m_open.maxValue = value;
+        m_prevTimeUs = timeUs;
+        m_prevDelta = 0;
+        m_prevCode = 0;
+        m_prevValue = 0;
+        m_prevLeading = -1;
+        m_prevTrailing = 0;
+    } else {
+        encodeTime(timeUs);
+        m_open.minValue = qMin(m_open.minValue, value);
+        m_open.maxValue = qMax(m_open.maxValue, value);
+    }
+    encodeValue(value);
+    m_open.lastTimeNs = timeUs * 1000;
+    m_open.count++;
+    if (m_open.count == 1)
+        m_index.append(value, value);
+    else
+        m_index.update(m_index.size() - 1, m_open.minValue, m_open.maxValue);
+
+    if (int(m_open.count) >= m_blockCapacity)
+        sealBlock();
+}
+
+void CompressedHistory::sealBlock()
+{
+    m_open.data = m_writer.bytes();
+    m_open.data.squeeze();
+    m_sealedCount += m_open.count;
+    m_sealedBytes += m_open.data.size();
+    m_sealed.append(m_open);
+    m_open = CompressedBlock();
+    m_writer.clear();
+    m_writer.data().reserve(m_blockCapacity * 3);
+}
+
+/*
+ * Delta-of-delta buckets, in microseconds:
+ *   0       -> dod == 0
+ *   10      -> 7 bit signed
+ *   110     -> 12 bit signed
+ *   1110    -> 20 bit signed
+ *   11110   -> 32 bit signed
+ *   11111   -> 64 bit
+ */
+void CompressedHistory::encodeTime(qint64 timeUs)
+{
+    const qint64 delta = timeUs - m_prevTimeUs;
+    const qint64 dod = delta - m_prevDelta;
+    if (dod == 0) {
+        m_writer.write(0, 1);
+    } else if (fitsSigned(dod, 7)) {
+        m_writer.write(0x2, 2);
+        m_writer.write(quint64(dod), 7);
+    } else if (fitsSigned(dod, 12)) {
+        m_writer.write(0x6, 3);
+        m_writer.write(quint64(dod), 12);
+    } else if (fitsSigned(dod, 20)) {
+        m_writer.write(0xE, 4);
+        m_writer.write(quint64(dod), 20);
+    } else if (fitsSigned(dod, 32)) {
+        m_writer.write(0x1E, 5);
+        m_writer.write(quint64(dod), 32);
+    } else {
+        m_writer.write(0x1F, 5);
+        m_writer.write(quint64(dod), 64);
+    }
+    m_prevDelta = delta;
+    m_prevTimeUs = timeUs;
+}
+
+void CompressedHistory::decodeTime(BitReader &reader, qint64 &timeUs, qint64 &delta)
+{
+    qint64 dod = 0;
+    if (reader.readBit()) {
+        if (!reader.readBit())
+            dod = signExtend(reader.read(7), 7);
+        else if (!reader.readBit())
+            dod = signExtend(reader.read(12), 12);
+        else if (!reader.readBit())
+            dod = signExtend(reader.read(20), 20);
+        else if (!reader.readBit())
+            dod = signExtend(reader.read(32), 32);
+        else
+            dod = qint64(reader.read(64));
+    }
+    //Wraps rather than overflowing when the bits are garbage
+    delta = qint64(quint64(delta) + quint64(dod));
+    timeUs = qint64(quint64(timeUs) + quint64(delta));
+}
+
+/*
+ * Quantized: code delta buckets, code = value / quantum
+ *   0       -> same code
+ *   10      -> 4 bit signed
+ *   110     -> 8 bit signed
+ *   1110    -> 16 bit signed
+ *   11110   -> 32 bit signed
+ *   11111   -> value is off the grid, raw 64 bit double follows
+ * Xor: Gorilla value encoding
+ *   0       -> same value
+ *   10      -> meaningful bits fit the previous leading/trailing window
+ *   11      -> 5 bit leading zeros, 6 bit length, then the meaningful bits
+ */
+void CompressedHistory::encodeValue(double value)
+{
+    if (m_encoding == Quantized) {
+        const double scaled = value / m_quantum;
+        const double rounded = std::floor(scaled + 0.5);
+        if (rounded == scaled && std::fabs(rounded) < 9.0e15 && double(qint64(rounded)) * m_quantum == value) {
+            const qint64 code = qint64(rounded);
+            const qint64 delta = code - m_prevCode;
+            if (delta == 0) {
+                m_writer.write(0, 1);
+            } else if (fitsSigned(delta, 4)) {
+                m_writer.write(0x2, 2);
+                m_writer.write(quint64(delta), 4);
+            } else if (fitsSigned(delta, 8)) {
+                m_writer.write(0x6, 3);
+                m_writer.write(quint64(delta), 8);
+            } else if (fitsSigned(delta, 16)) {
+                m_writer.write(0xE, 4);
+                m_writer.write(quint64(delta), 16);
+            } else if (fitsSigned(delta, 32)) {
+                m_writer.write(0x1E, 5);
+                m_writer.write(quint64(delta), 32);
+            } else {
+                m_writer.write(0x1F, 5);
+                m_writer.write(doubleBits(value), 64);
+                return;
+            }
+            m_prevCode = code;
+        } else {
+            m_writer.write(0x1F, 5);
+            m_writer.write(doubleBits(value), 64);
+        }
+        return;
+    }
+
+    const quint64 bits = doubleBits(value);
+    const quint64 x = bits ^ doubleBits(m_prevValue);
+    m_prevValue = value;
+    if (x == 0) {
+        m_writer.write(0, 1);
+        return;
+    }
+    const int leading = qMin(leadingZeros(x), 31);
+    const int trailing = trailingZeros(x);
+    if (m_prevLeading >= 0 && leading >= m_prevLeading && trailing >= m_prevTrailing) {
+        const int length = 64 - m_prevLeading - m_prevTrailing;
+        m_writer.write(0x2, 2);
+        m_writer.write(x >> m_prevTrailing, length);
+        return;
+    }
+    const int length = 64 - leading - trailing;
+    m_writer.write(0x3, 2);
+    m_writer.write(quint64(leading), 5);
+    m_writer.write(quint64(length & 63), 6);
+    m_writer.write(x >> trailing, length);
+    m_prevLeading = leading;
+    m_prevTrailing = trailing;
+}
+
+double CompressedHistory::decodeValue(BitReader &reader, qint64 &code, double &previous,
+                                      int &leading, int &trailing) const
+{
+    if (m_encoding == Quantized) {
+        if (!reader.readBit())
+            return code * m_quantum;
+        qint64 delta;
+        if (!reader.readBit())
+            delta = signExtend(reader.read(4), 4);
+        else if (!reader.readBit())
+            delta = signExtend(reader.read(8), 8);
+        else if (!reader.readBit())
+            delta = signExtend(reader.read(16), 16);
+        else if (!reader.readBit())
+            delta = signExtend(reader.read(32), 32);
+        else
+            return bitsDouble(reader.read(64));
+        code += delta;
+        return code * m_quantum;
+    }
+
+    if (!reader.readBit())
+        return previous;
+    if (reader.readBit()) {
+        leading = int(reader.read(5));
+        int length = int(reader.read(6));
+        if (length == 0)
+            length = 64;
+        trailing = 64 - leading - length;
+    }
+    //No window yet, or one reaching past bit 0: only a damaged file gets here
+    if (leading < 0 || trailing < 0)
+        return previous;
+    const int length = 64 - leading - trailing;
+    const quint64 x = reader.read(length) << trailing;
+    previous = bitsDouble(doubleBits(previous) ^ x);
+    return previous;
+}
+
+bool CompressedHistory::save(QIODevice *device) const
+{
+    QDataStream out(device);
+    out.setVersion(QDataStream::Qt_5_6);
+    const QVector<CompressedBlock> all = blocks();
+    out << HistoryFileMagic << HistoryFileVersion
+        << qint32(m_encoding) << m_quantum << qint32(all.size());
+    for (const CompressedBlock &block : all) {
+        out << block.firstTimeNs << block.lastTimeNs << block.minValue << block.maxValue
+            << block.count << qint32(block.data.size());
+        out.writeRawData(block.data.constData(), block.data.size());
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+bool CompressedHistory::load(QIODevice *device)
+{
+    QDataStream in(device);
+    in.setVersion(QDataStream::Qt_5_6);
+    quint32 magic = 0, version = 0;
+    qint32 encoding = -1, blockCount = -1;
+    double quantum = 0;
+    in >> magic >> version >> encoding >> quantum >> blockCount;
+    if (in.status() != QDataStream::Ok || magic != HistoryFileMagic || version != HistoryFileVersion
+            || (encoding != Quantized && encoding != Xor) || blockCount < 0)
+        return false;
+
+    QVector<CompressedBlock> loaded;
+    loaded.reserve(blockCount);
+    qint64 samples = 0;
+    qint64 bytes = 0;
+    for (qint32 i = 0; i < blockCount; i++) {
+        CompressedBlock block;
+        qint32 size = -1;
+        in >> block.firstTimeNs >> block.lastTimeNs >> block.minValue >> block.maxValue
+           >> block.count >> size;
+        if (in.status() != QDataStream::Ok || size < 0)
+            return false;
+        //Decoding trusts count, so it has to fit the block and agree with the byte size
+        if (block.count == 0 || block.count > quint32(m_blockCapacity)
+                || qint64(size) * 8 < qint64(block.count - 1) * MinSampleBits + 1
+                || qint64(size) > (qint64(block.count) * MaxSampleBits + 7) / 8)
+            return false;
+        block.data.resize(size);
+        if (in.readRawData(block.data.data(), size) != size)
+            return false;
+        samples += block.count;
+        bytes += size;
+        loaded.append(block);
+    }
+
+    //Loaded blocks are all treated as sealed, appends start a new block after them
+    clear();
+    m_encoding = ValueEncoding(encoding);
+    m_quantum = quantum;
+    m_sealed = loaded;
+    for (const CompressedBlock &block : loaded)
+        m_index.append(block.minValue, block.maxValue);
+    m_sealedCount = samples;
+    m_sealedBytes = bytes;
+    return true;
+}
@@ -0,0 +1,181 @@
+/*
+ * Purpose: Compressed storage for the temperature history, so months of samples fit in RAM
+ * or on disk on a small PC. Samples are packed into blocks Gorilla style:
+ *   - timestamps as delta-of-delta (a steady cadence costs one bit per sample)
+ *   - values either as deltas of the sensor code (Quantized, one bit when unchanged)
+ *     or as the XOR of consecutive doubles (Xor) when values are not on a fixed grid
+ * Encoding is streaming on append, a block is sealed once it holds blockCapacity() samples.
+ * Times are kept with microsecond resolution.
+ * */
+
+#ifndef COMPRESSEDHISTORY_H
+#define COMPRESSEDHISTORY_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+
+#include "minmaxindex.h"
+
+class QIODevice;
+
+//Appends bits MSB first to a byte array through a 64 bit accumulator
+class BitWriter
+{
+public:
+    void write(quint64 bits, int count);
+    //Bytes written so far, including the partial last byte
+    QByteArray bytes() const;
+    void clear();
+    int bitCount() const { return m_data.size() * 8 + m_pending; }
+    QByteArray &data() { return m_data; }
+
+private:
+    QByteArray m_data;
+    quint64 m_acc = 0;
+    int m_pending = 0;
+};
+
+class BitReader
+{
+public:
+    BitReader(const char *data, int size) :
+        m_data(reinterpret_cast<const uchar *>(data)), m_end(m_data + size) {}
+    quint64 read(int count);
+    bool readBit() { return read(1) != 0; }
+
+private:
+    void refill();
+
+    const uchar *m_data;
+    const uchar *m_end;
+    quint64 m_acc = 0;
+    int m_available = 0;
+};
+
+struct CompressedBlock
+{
+    qint64 firstTimeNs = 0;
+    qint64 lastTimeNs = 0;
+    double minValue = 0;
+    double maxValue = 0;
+    quint32 count = 0;
+    QByteArray data;
+};
+
+class CompressedHistory
+{
+public:
+    enum ValueEncoding {
+        Quantized,  //Value deltas in units of quantum, exact for sensor codes, falls back per sample
+        Xor         //Gorilla XOR of the raw doubles, for values that are not on a grid
+    };
+
+    explicit CompressedHistory(ValueEncoding encoding = Quantized, double quantum = 1.0 / 128,
+                               int blockCapacity = 4096);
+
+    void append(qint64 timeNs, double value);
+    void clear();
+
+    qint64 count() const { return m_sealedCount + m_open.count; }
+    bool isEmpty() const { return count() == 0; }
+    qint64 firstTimeNs() const;
+    qint64 lastTimeNs() const;
+    int blockCapacity() const { return m_blockCapacity; }
+    ValueEncoding valueEncoding() const { return m_encoding; }
+    double quantum() const { return m_quantum; }
+    //Compressed bytes held, sealed blocks plus the open one
+    qint64 byteSize() const;
+
+    //Sealed blocks followed by a snapshot of the open block. Blocks are implicitly shared,
+    //so the list is cheap to take and stays valid while appends continue.
+    QVector<CompressedBlock> blocks() const;
+
+    //Decodes every sample of block into the callback f(qint64 timeNs, double value)
+    template <typename F>
+    void decodeBlock(const CompressedBlock &block, F f) const;
+
+    //Calls f(timeNs, value) for every sample with fromNs <= timeNs <= toNs, in time order.
+    //Only the blocks overlapping the range are decoded, found by binary search.
+    template <typename F>
+    void forEachInRange(qint64 fromNs, qint64 toNs, F f) const;
+
+    //Min/max of the samples in [fromNs, toNs] in O(log n): whole blocks come from the
+    //block index, only the (at most two) blocks straddling the ends are decoded.
+    //Returns false when no sample falls in the range.
+    bool minMaxInRange(qint64 fromNs, qint64 toNs, double &min, double &max) const;
+
+    bool save(QIODevice *device) const;
+    bool load(QIODevice *device);
+
+private:
+    int blockTotal() const { return m_sealed.size() + (m_open.count ? 1 : 0); }
+    //Block i with its data, the open block is the last one
+    CompressedBlock blockAt(int i) const;
+    //First block whose last sample is at or after timeNs, blockTotal() if none
+    int firstBlockEndingAfter(qint64 timeNs) const;
+
+    void sealBlock();
+    void encodeTime(qint64 timeUs);
+    void encodeValue(double value);
+    static void decodeTime(BitReader &reader, qint64 &timeUs, qint64 &delta);
+    double decodeValue(BitReader &reader, qint64 &code, double &previous, int &leading, int &trailing) const;
+
+    ValueEncoding m_encoding;
+    double m_quantum;
+    int m_blockCapacity;
+
+    QVector<CompressedBlock> m_sealed;
+    MinMaxIndex m_index;  //one leaf per block, the open block included
+    qint64 m_sealedCount = 0;
+    qint64 m_sealedBytes = 0;
+
+    //Open block and its encoder state
+    CompressedBlock m_open;
+    BitWriter m_writer;
+    qint64 m_prevTimeUs = 0;
+    qint64 m_prevDelta = 0;
+    qint64 m_prevCode = 0;
+    double m_prevValue = 0;
+    int m_prevLeading = -1;
+    int m_prevTrailing = 0;
+};
+
+template <typename F>
+void CompressedHistory::decodeBlock(const CompressedBlock &block, F f) const
+{
+    BitReader reader(block.data.constData(), block.data.size());
+    qint64 timeUs = block.firstTimeNs / 1000;
+    qint64 delta = 0;
+    qint64 code = 0;
+    double previous = 0;
+    int leading = -1;
+    int trailing = 0;
+    for (quint32 i = 0; i < block.count; i++) {
+        if (i > 0)
+            decodeTime(reader, timeUs, delta);
+        const double value = decodeValue(reader, code, previous, leading, trailing);
+        f(timeUs * 1000, value);
+    }
+}
+
+template <typename F>
+void CompressedHistory::forEachInRange(qint64 fromNs, qint64 toNs, F f) const
+{
+    const int total = blockTotal();
+    for (int i = firstBlockEndingAfter(fromNs); i < total; i++) {
+        const CompressedBlock block = blockAt(i);
+        if (block.firstTimeNs > toNs)
+            break;
+        if (block.firstTimeNs >= fromNs && block.lastTimeNs <= toNs) {
+            decodeBlock(block, f);
+            continue;
+        }
+        decodeBlock(block, [&](qint64 t, double v) {
+            if (t >= fromNs && t <= toNs)
+                f(t, v);
+        });
+    }
+}
+
+#endif // COMPRESSEDHISTORY_H
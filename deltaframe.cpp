@@ -0,0 +1,36 @@
+#include "deltaframe.h"
+
+void DeltaFrameDecoder::reset()
+{
+    m_pending.resize(0);
+    m_badFrames = 0;
+    m_skippedBytes = 0;
+}
+
+bool DeltaFrameDecoder::decodeFrame(const uchar *data, int count)
+{
+    const int length = DeltaFrame::frameBytes(count);
+    uchar sum = 0;
+    for (int i = 1; i < length - 1; i++)
+        sum = uchar(sum + data[i]);
+    if (sum != data[length - 1])
+        return false;
+
+    //Sign extend both nibbles of every byte. No dependencies between iterations, so this
+    //becomes a handful of vector instructions for a whole frame.
+    const uchar *packed = data + DeltaFrame::HeaderBytes;
+    const int pairs = count / 2;
+    for (int k = 0; k < pairs; k++) {
+        m_deltas[2 * k] = qint16(qint8(packed[k]) >> 4);
+        m_deltas[2 * k + 1] = qint16(qint8(uchar(packed[k] << 4)) >> 4);
+    }
+
+    const int step = 1 << (data[1] & 3);
+    quint16 reading = quint16((data[4] << 8) | data[5]);
+    m_readings[0] = reading;
+    for (int k = 1; k < count; k++) {
+        reading = quint16(reading + m_deltas[k - 1] * step);
+        m_readings[k] = reading;
+    }
+    return true;
+}
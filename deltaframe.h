@@ -0,0 +1,117 @@
+/*
+ * Purpose: Decoder for the firmware's delta frame wire format (WIRE_DELTA in main.c), which
+ * packs up to 64 readings into one frame instead of sending each as two bytes:
+ *
+ *   0xA5 sync
+ *   (count - 1) << 2 | shift
+ *   counter of the first reading (u16, big endian), readings are numbered by the board
+ *   first reading (u16, big endian)
+ *   count - 1 signed 4 bit deltas, high nibble first, each in units of 1 << shift
+ *   checksum, the sum of every byte after the sync byte, mod 256
+ *
+ * feed() parses straight out of the caller's buffer; only a frame split across reads is copied.
+ * The nibbles are unpacked in a flat loop the compiler vectorises, then summed.
+ * */
+
+#ifndef DELTAFRAME_H
+#define DELTAFRAME_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+namespace DeltaFrame {
+static const uchar Sync = 0xA5;
+static const int HeaderBytes = 6;
+static const int MaxReadings = 64;
+static const int MaxFrameBytes = HeaderBytes + MaxReadings / 2 + 1;
+
+//count - 1 nibbles round up to count / 2 bytes, plus the checksum
+inline int frameBytes(int count) { return HeaderBytes + count / 2 + 1; }
+}
+
+class DeltaFrameDecoder
+{
+public:
+    void reset();
+
+    //Calls sink(quint16 counter, const quint16 *readings, int count) for every good frame in
+    //data, and keeps a trailing partial frame for the next call
+    template <typename Sink>
+    void feed(const uchar *data, int size, Sink sink);
+
+    //Frames that failed the checksum and bytes skipped looking for a sync byte
+    quint64 badFrames() const { return m_badFrames; }
+    quint64 skippedBytes() const { return m_skippedBytes; }
+
+private:
+    template <typename Sink>
+    int parse(const uchar *data, int size, Sink &sink);
+    //Checks and unpacks the frame at data into m_readings, false on a bad checksum
+    bool decodeFrame(const uchar *data, int count);
+
+    QByteArray m_pending;
+    qint16 m_deltas[DeltaFrame::MaxReadings];
+    quint16 m_readings[DeltaFrame::MaxReadings];
+    quint64 m_badFrames = 0;
+    quint64 m_skippedBytes = 0;
+};
+
+template <typename Sink>
+int DeltaFrameDecoder::parse(const uchar *data, int size, Sink &sink)
+{
+    int i = 0;
+    while (i < size) {
+        if (data[i] != DeltaFrame::Sync) {
+            m_skippedBytes++;
+            i++;
+            continue;
+        }
+        if (size - i < 2)
+            break;
+        const int count = (data[i + 1] >> 2) + 1;
+        const int length = DeltaFrame::frameBytes(count);
+        if (size - i < length)
+            break;
+        if (!decodeFrame(data + i, count)) {
+            //A sync byte inside some other frame's data, or damage. Look again one byte on.
+            m_badFrames++;
+            i++;
+            continue;
+        }
+        sink(quint16((data[i + 2] << 8) | data[i + 3]), m_readings, count);
+        i += length;
+    }
+    return i;
+}
+
+template <typename Sink>
+void DeltaFrameDecoder::feed(const uchar *data, int size, Sink sink)
+{
+    if (!m_pending.isEmpty()) {
+        //Finish the frame left over from the last read. One frame's worth of bytes is all it
+        //can need, after that the rest is parsed in place again.
+        const int old = m_pending.size();
+        const int take = qMin(size, DeltaFrame::MaxFrameBytes);
+        m_pending.append(reinterpret_cast<const char *>(data), take);
+        int used = parse(reinterpret_cast<const uchar *>(m_pending.constData()), m_pending.size(), sink);
+        if (used < old && take < size) {
+            //Still stuck inside the old bytes (a short bad frame), do it the slow way
+            m_pending.append(reinterpret_cast<const char *>(data) + take, size - take);
+            used += parse(reinterpret_cast<const uchar *>(m_pending.constData()) + used,
+                          m_pending.size() - used, sink);
+            m_pending.remove(0, used);
+            return;
+        }
+        if (used < old || take == size) {
+            m_pending.remove(0, used);
+            return;
+        }
+        m_pending.resize(0);
+        data += used - old;
+        size -= used - old;
+    }
+    const int used = parse(data, size, sink);
+    m_pending.append(reinterpret_cast<const char *>(data) + used, size - used);
+}
+
+#endif // DELTAFRAME_H
@@ -0,0 +1,29 @@
+#-------------------------------------------------
+#
+# main.c built for a Linux host against mock Xilinx drivers
+#
+#-------------------------------------------------
+
+TEMPLATE = app
+TARGET = firmware_host
+CONFIG += console
+CONFIG -= qt app_bundle
+
+QMAKE_CFLAGS += -std=gnu99
+INCLUDEPATH += .
+
+SOURCES += ../main.c \
+    mock_xilinx.c
+
+HEADERS += xgpio_l.h \
+    xiic.h \
+    xil_exception.h \
+    xil_printf.h \
+    xil_types.h \
+    xintc.h \
+    xparameters.h \
+    xstatus.h \
+    xtmrctr.h \
+    xuartlite.h
+
+LIBS += -lpthread -lm
@@ -0,0 +1,22 @@
+/*
+ * Host build stand-in for the GPIO low level register macros.
+ * Writes to the seven segment display land in MockSevenSegment.
+ * */
+
+#ifndef XGPIO_L_H
+#define XGPIO_L_H
+
+#include "xil_types.h"
+
+#define XGPIO_DATA_OFFSET 0x0
+#define XGPIO_TRI_OFFSET 0x4
+#define XGPIO_CHAN_OFFSET 0x8
+
+extern volatile u32 MockSevenSegment;
+
+#define XGpio_WriteReg(BaseAddress, RegOffset, Data) \
+    ((void)(BaseAddress), (void)(RegOffset), MockSevenSegment = (u32)(Data))
+#define XGpio_ReadReg(BaseAddress, RegOffset) \
+    ((void)(BaseAddress), (void)(RegOffset), MockSevenSegment)
+
+#endif /* XGPIO_L_H */
@@ -0,0 +1,58 @@
+/*
+ * Host build stand-in for the AXI IIC driver, interrupt mode master receive only.
+ * The bus holds mock ADT7420 sensors (mock_xilinx.c); a receive completes after the time
+ * the transfer takes at MOCK_I2C_HZ and is reported through the recv or status handler.
+ * */
+
+#ifndef XIIC_H
+#define XIIC_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+#define XII_ADDR_TO_SEND_TYPE 1
+#define XII_ADDR_TO_RESPOND_TYPE 2
+
+#define XII_BUS_NOT_BUSY_EVENT 0x00000001
+#define XII_ARB_LOST_EVENT 0x00000002
+#define XII_SLAVE_NO_ACK_EVENT 0x00000004
+#define XII_MASTER_READ_EVENT 0x00000008
+#define XII_MASTER_WRITE_EVENT 0x00000010
+#define XII_GENERAL_CALL_EVENT 0x00000020
+
+typedef void (*XIic_Handler)(void *CallBackRef, int ByteCount);
+typedef void (*XIic_StatusHandler)(void *CallBackRef, int StatusEvent);
+
+typedef struct {
+    u16 DeviceId;
+    UINTPTR BaseAddress;
+    int Has10BitAddr;
+    u8 GpOutWidth;
+} XIic_Config;
+
+typedef struct {
+    XIic_Config Config;
+    u32 IsReady;
+    u32 IsStarted;
+    u8 AddrOfSlave;
+    XIic_Handler RecvHandler;
+    void *RecvCallBackRef;
+    XIic_StatusHandler StatusHandler;
+    void *StatusCallBackRef;
+    u8 *RecvBufferPtr;
+    volatile int RecvByteCount;
+    volatile int Busy;
+} XIic;
+
+XIic_Config *XIic_LookupConfig(u16 DeviceId);
+int XIic_CfgInitialize(XIic *InstancePtr, XIic_Config *ConfigPtr, UINTPTR EffectiveAddr);
+int XIic_Start(XIic *InstancePtr);
+int XIic_Stop(XIic *InstancePtr);
+int XIic_SetAddress(XIic *InstancePtr, int AddressType, int Address);
+void XIic_SetRecvHandler(XIic *InstancePtr, void *CallBackRef, XIic_Handler FuncPtr);
+void XIic_SetSendHandler(XIic *InstancePtr, void *CallBackRef, XIic_Handler FuncPtr);
+void XIic_SetStatusHandler(XIic *InstancePtr, void *CallBackRef, XIic_StatusHandler FuncPtr);
+int XIic_MasterRecv(XIic *InstancePtr, u8 *RxMsgPtr, int ByteCount);
+void XIic_InterruptHandler(void *InstancePtr);
+
+#endif /* XIIC_H */
@@ -0,0 +1,20 @@
+/*
+ * Host build stand-in for xil_exception.h. The registered interrupt handler runs on the
+ * mock interrupt thread (see mock_xilinx.c) once exceptions are enabled.
+ * */
+
+#ifndef XIL_EXCEPTION_H
+#define XIL_EXCEPTION_H
+
+#include "xil_types.h"
+
+#define XIL_EXCEPTION_ID_INT 1
+
+typedef void (*Xil_ExceptionHandler)(void *Data);
+
+void Xil_ExceptionInit(void);
+void Xil_ExceptionRegisterHandler(u32 Id, Xil_ExceptionHandler Handler, void *Data);
+void Xil_ExceptionEnable(void);
+void Xil_ExceptionDisable(void);
+
+#endif /* XIL_EXCEPTION_H */
@@ -0,0 +1,10 @@
+/*
+ * Host build stand-in for xil_printf, prints to stderr since stdout may be the UART
+ * */
+
+#ifndef XIL_PRINTF_H
+#define XIL_PRINTF_H
+
+void xil_printf(const char *format, ...);
+
+#endif /* XIL_PRINTF_H */
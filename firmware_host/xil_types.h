@@ -0,0 +1,26 @@
+/*
+ * Host build stand-in for the Xilinx standalone BSP types.
+ * Only what main.c uses is provided.
+ * */
+
+#ifndef XIL_TYPES_H
+#define XIL_TYPES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef uintptr_t UINTPTR;
+
+#ifndef TRUE
+#define TRUE 1U
+#endif
+#ifndef FALSE
+#define FALSE 0U
+#endif
+
+#endif /* XIL_TYPES_H */
@@ -0,0 +1,38 @@
+/*
+ * Host build stand-in for the AXI interrupt controller driver.
+ * Mock devices raise their vector, the controller dispatches enabled vectors to the
+ * connected handlers from the interrupt thread.
+ * */
+
+#ifndef XINTC_H
+#define XINTC_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+#define XIN_REAL_MODE 1
+#define XIN_SIMULATION_MODE 0
+#define XINTC_MAX_NUM_INTR_INPUTS 32
+
+typedef void (*XInterruptHandler)(void *InstancePtr);
+
+typedef struct {
+    XInterruptHandler Handler;
+    void *CallBackRef;
+} XIntc_VectorTableEntry;
+
+typedef struct {
+    u16 DeviceId;
+    u32 IsStarted;
+    volatile u32 EnabledMask;
+    XIntc_VectorTableEntry HandlerTable[XINTC_MAX_NUM_INTR_INPUTS];
+} XIntc;
+
+int XIntc_Initialize(XIntc *InstancePtr, u16 DeviceId);
+int XIntc_Connect(XIntc *InstancePtr, u8 Id, XInterruptHandler Handler, void *CallBackRef);
+int XIntc_Start(XIntc *InstancePtr, u8 Mode);
+void XIntc_Enable(XIntc *InstancePtr, u8 Id);
+void XIntc_Disable(XIntc *InstancePtr, u8 Id);
+void XIntc_InterruptHandler(XIntc *InstancePtr);
+
+#endif /* XINTC_H */
@@ -0,0 +1,26 @@
+/*
+ * Host build stand-in for the xparameters.h Vivado generates for the block design.
+ * Device IDs and interrupt vectors match the hardware, base addresses are only tags.
+ * */
+
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+
+#define XPAR_UARTLITE_0_DEVICE_ID 0
+#define XPAR_UARTLITE_0_BASEADDR 0x40600000
+#define XPAR_UARTLITE_0_BAUDRATE 115200
+
+#define XPAR_IIC_0_DEVICE_ID 0
+#define XPAR_IIC_0_BASEADDR 0x40800000
+
+#define XPAR_INTC_0_DEVICE_ID 0
+#define XPAR_INTC_0_IIC_0_VEC_ID 0
+#define XPAR_INTC_0_UARTLITE_0_VEC_ID 1
+
+#define XPAR_AXI_GPIO_0_BASEADDR 0x40000000
+
+#define XPAR_TMRCTR_0_DEVICE_ID 0
+#define XPAR_TMRCTR_0_BASEADDR 0x41C00000
+#define XPAR_TMRCTR_0_CLOCK_FREQ_HZ 100000000
+
+#endif /* XPARAMETERS_H */
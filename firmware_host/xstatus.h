@@ -0,0 +1,13 @@
+/*
+ * Host build stand-in for xstatus.h
+ * */
+
+#ifndef XSTATUS_H
+#define XSTATUS_H
+
+#define XST_SUCCESS 0L
+#define XST_FAILURE 1L
+#define XST_DEVICE_NOT_FOUND 2L
+#define XST_IIC_BUS_BUSY 1123L
+
+#endif /* XSTATUS_H */
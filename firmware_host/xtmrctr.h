@@ -0,0 +1,30 @@
+/*
+ * Host build stand-in for the AXI Timer driver, polled use only.
+ * A started counter counts up at XPAR_TMRCTR_0_CLOCK_FREQ_HZ from the host's monotonic
+ * clock and wraps at 32 bits like the hardware.
+ * */
+
+#ifndef XTMRCTR_H
+#define XTMRCTR_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+#define XTC_DEVICE_TIMER_COUNT 2
+#define XTC_AUTO_RELOAD_OPTION 0x00000010UL
+
+typedef struct {
+    u32 IsReady;
+    u32 Options[XTC_DEVICE_TIMER_COUNT];
+    u32 ResetValue[XTC_DEVICE_TIMER_COUNT];
+    int64_t StartedAt[XTC_DEVICE_TIMER_COUNT];   /* host ns, 0 while stopped */
+} XTmrCtr;
+
+int XTmrCtr_Initialize(XTmrCtr *InstancePtr, u16 DeviceId);
+void XTmrCtr_SetOptions(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 Options);
+void XTmrCtr_SetResetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 ResetValue);
+void XTmrCtr_Start(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+void XTmrCtr_Stop(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+u32 XTmrCtr_GetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+
+#endif /* XTMRCTR_H */
@@ -0,0 +1,46 @@
+/*
+ * Host build stand-in for the UART Lite driver, interrupt mode.
+ * Sent bytes drain at MOCK_BAUD into a pty (or the file named by MOCK_UART_OUT), and the
+ * send handler runs from the interrupt thread once the last byte has left.
+ * */
+
+#ifndef XUARTLITE_H
+#define XUARTLITE_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+typedef void (*XUartLite_Handler)(void *CallBackRef, unsigned int ByteCount);
+
+typedef struct {
+    u16 DeviceId;
+    UINTPTR RegBaseAddr;
+    u32 BaudRate;
+    u8 UseParity;
+    u8 ParityOdd;
+    u8 DataBits;
+} XUartLite_Config;
+
+typedef struct {
+    UINTPTR RegBaseAddress;
+    u32 IsReady;
+    XUartLite_Handler SendHandler;
+    void *SendCallBackRef;
+    XUartLite_Handler RecvHandler;
+    void *RecvCallBackRef;
+    volatile unsigned int SendRequested;
+} XUartLite;
+
+XUartLite_Config *XUartLite_LookupConfig(u16 DeviceId);
+int XUartLite_Initialize(XUartLite *InstancePtr, u16 DeviceId);
+int XUartLite_SelfTest(XUartLite *InstancePtr);
+unsigned int XUartLite_Send(XUartLite *InstancePtr, u8 *DataBufferPtr, unsigned int NumBytes);
+unsigned int XUartLite_Recv(XUartLite *InstancePtr, u8 *DataBufferPtr, unsigned int NumBytes);
+int XUartLite_IsSending(XUartLite *InstancePtr);
+void XUartLite_SetSendHandler(XUartLite *InstancePtr, XUartLite_Handler FuncPtr, void *CallBackRef);
+void XUartLite_SetRecvHandler(XUartLite *InstancePtr, XUartLite_Handler FuncPtr, void *CallBackRef);
+void XUartLite_EnableInterrupt(XUartLite *InstancePtr);
+void XUartLite_DisableInterrupt(XUartLite *InstancePtr);
+void XUartLite_InterruptHandler(XUartLite *InstancePtr);
+
+#endif /* XUARTLITE_H */
@@ -0,0 +1,52 @@
+#include "framecodec.h"
+
+#include <QCoreApplication>
+
+namespace {
+
+//ADT7420 16 bit register as sent by WIRE_RAW16, flag bits included as the firmware always did
+WordCodec<2, ByteOrder::BigEndian, true, 0, std::ratio<1, 128>> adt7420;
+//ADT7420 13 bit mode with the three flag bits dropped
+WordCodec<2, ByteOrder::BigEndian, true, 3, std::ratio<1, 16>> adt7420Flags;
+//TMP102 / TMP75, 12 bit left aligned
+WordCodec<2, ByteOrder::BigEndian, true, 4, std::ratio<1, 16>> tmp102;
+//LM75, 9 bit left aligned
+WordCodec<2, ByteOrder::BigEndian, true, 7, std::ratio<1, 2>> lm75;
+//Si7051, unsigned 16 bit, T = 175.72 * code / 65536 - 46.85
+WordCodec<2, ByteOrder::BigEndian, false, 0, std::ratio<17572, 6553600>, std::ratio<-4685, 100>> si7051;
+//Microcontroller firmware sending centidegrees, little endian, behind a 0x55 sync byte
+WordCodec<2, ByteOrder::LittleEndian, true, 0, std::ratio<1, 100>, std::ratio<0>, SyncFramed<0x55>> centiSync;
+//Linux hwmon style millidegrees, 32 bit little endian
+WordCodec<4, ByteOrder::LittleEndian, true, 0, std::ratio<1, 1000>> milli32;
+
+struct Entry {
+    const char *name;
+    const FrameCodec *codec;
+};
+
+const Entry entries[] = {
+    {QT_TRANSLATE_NOOP("FrameCodecRegistry", "ADT7420, 16 bit readings"), &adt7420},
+    {QT_TRANSLATE_NOOP("FrameCodecRegistry", "ADT7420, 13 bit without flags"), &adt7420Flags},
+    {QT_TRANSLATE_NOOP("FrameCodecRegistry", "TMP102 / TMP75, 12 bit"), &tmp102},
+    {QT_TRANSLATE_NOOP("FrameCodecRegistry", "LM75, 9 bit"), &lm75},
+    {QT_TRANSLATE_NOOP("FrameCodecRegistry", "Si7051, 14 bit"), &si7051},
+    {QT_TRANSLATE_NOOP("FrameCodecRegistry", "0x55 + centidegrees, little endian"), &centiSync},
+    {QT_TRANSLATE_NOOP("FrameCodecRegistry", "Millidegrees, 32 bit little endian"), &milli32},
+};
+
+}
+
+int FrameCodecRegistry::count()
+{
+    return int(sizeof(entries) / sizeof(entries[0]));
+}
+
+QString FrameCodecRegistry::name(int index)
+{
+    return QCoreApplication::translate("FrameCodecRegistry", entries[index].name);
+}
+
+const FrameCodec &FrameCodecRegistry::codec(int index)
+{
+    return *entries[qBound(0, index, count() - 1)].codec;
+}
@@ -0,0 +1,120 @@
+/*
+ * Purpose: Decoders for sensors that send one fixed size reading per frame, so the monitor can
+ * read other I2C temperature sensors than the ADT7420 without touching the decode path.
+ *
+ * WordCodec is parameterised at compile time by word width, byte order, signedness, a right
+ * shift for flag bits below the reading, scale and offset to Celsius, and framing (back to back
+ * words, or a sync byte before each). Everything about the layout is a constant in the loop, so
+ * each instantiation compiles to its own straight line decode with no per-byte decisions.
+ *
+ * FrameCodecRegistry lists the instantiations the settings dialog offers. Adding a sensor is
+ * one line there.
+ * */
+
+#ifndef FRAMECODEC_H
+#define FRAMECODEC_H
+
+#include <QString>
+#include <QtGlobal>
+
+#include <ratio>
+
+class FrameCodec
+{
+public:
+    virtual ~FrameCodec() {}
+
+    virtual int frameBytes() const = 0;
+    //Decodes the whole frames at the start of data into raw codes and Celsius, count of them.
+    //raw and celsius need room for size / frameBytes() readings. Returns the bytes used, what is
+    //left is the start of a frame still arriving.
+    virtual int decode(const uchar *data, int size, quint32 *raw, double *celsius, int &count) const = 0;
+};
+
+enum class ByteOrder { BigEndian, LittleEndian };
+
+//Framing policies
+struct Unframed
+{
+    static const int Bytes = 0;
+    static bool matches(const uchar *) { return true; }
+};
+
+template <uchar Sync>
+struct SyncFramed
+{
+    static const int Bytes = 1;
+    static bool matches(const uchar *frame) { return frame[0] == Sync; }
+};
+
+template <int WordBytes, ByteOrder Order, bool Signed, int Shift, typename Scale,
+          typename Offset = std::ratio<0>, typename Framing = Unframed>
+class WordCodec : public FrameCodec
+{
+    static_assert(WordBytes >= 1 && WordBytes <= 4, "words are 1 to 4 bytes");
+
+public:
+    static const int FrameBytes = Framing::Bytes + WordBytes;
+
+    int frameBytes() const override { return FrameBytes; }
+
+    static quint32 word(const uchar *frame)
+    {
+        const uchar *p = frame + Framing::Bytes;
+        quint32 w = 0;
+        for (int i = 0; i < WordBytes; i++)
+            w |= quint32(p[i]) << (8 * (Order == ByteOrder::BigEndian ? WordBytes - 1 - i : i));
+        return w;
+    }
+
+    static double celsius(quint32 w)
+    {
+        //Sign extend from the top of the word, then drop the flag bits
+        const int unused = 32 - 8 * WordBytes;
+        const qint64 v = Signed ? qint64(qint32(w << unused) >> unused) : qint64(w);
+        return double(v >> Shift) * (double(Scale::num) / Scale::den) + double(Offset::num) / Offset::den;
+    }
+
+    int decode(const uchar *data, int size, quint32 *raw, double *values, int &count) const override
+    {
+        if (Framing::Bytes == 0) {
+            count = size / FrameBytes;
+            for (int k = 0; k < count; k++) {
+                const quint32 w = word(data + k * FrameBytes);
+                raw[k] = w;
+                values[k] = celsius(w);
+            }
+            return count * FrameBytes;
+        }
+
+        //Framed: step over anything that is not a sync byte, including in a partial frame at
+        //the end, so what is left over always starts a frame
+        count = 0;
+        int i = 0;
+        while (i < size) {
+            if (!Framing::matches(data + i)) {
+                i++;
+                continue;
+            }
+            if (size - i < FrameBytes)
+                break;
+            const quint32 w = word(data + i);
+            raw[count] = w;
+            values[count] = celsius(w);
+            count++;
+            i += FrameBytes;
+        }
+        return i;
+    }
+};
+
+namespace FrameCodecRegistry {
+//Index of the ADT7420 codec that matches WIRE_RAW16 in main.c
+static const int Adt7420 = 0;
+
+int count();
+QString name(int index);
+const FrameCodec &codec(int index);
+}
+
+#endif // FRAMECODEC_H
@@ -0,0 +1,134 @@
+#include "historychartview.h"
+
+#include <QDateTimeAxis>
+#include <QMouseEvent>
+#include <QRubberBand>
+#include <QWheelEvent>
+#include <QtMath>
+
+//Never zoom in closer than this, the axis labels stop making sense
+static const qreal MinimumSpanMs = 10;
+
+HistoryChartView::HistoryChartView(QWidget *parent) :
+    QChartView(parent),
+    m_rubberBand(new QRubberBand(QRubberBand::Rectangle, this))
+{
+    setRubberBand(QChartView::NoRubberBand);
+}
+
+bool HistoryChartView::currentRange(qreal &fromMs, qreal &toMs) const
+{
+    if (!chart())
+        return false;
+    const QList<QAbstractAxis *> axes = chart()->axes(Qt::Horizontal);
+    if (axes.isEmpty())
+        return false;
+    QDateTimeAxis *axis = qobject_cast<QDateTimeAxis *>(axes.first());
+    if (!axis)
+        return false;
+    fromMs = axis->min().toMSecsSinceEpoch();
+    toMs = axis->max().toMSecsSinceEpoch();
+    return toMs > fromMs;
+}
+
+qreal HistoryChartView::plotFraction(const QPoint &pos) const
+{
+    const QRectF plot = chart()->plotArea();
+    const QPointF inChart = chart()->mapFromScene(mapToScene(pos));
+    if (plot.width() <= 0)
+        return 0;
+    return qBound<qreal>(0, (inChart.x() - plot.left()) / plot.width(), 1);
+}
+
+void HistoryChartView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_selecting = true;
+        m_origin = event->pos();
+        m_rubberBand->setGeometry(QRect(m_origin, QSize()));
+        m_rubberBand->show();
+        event->accept();
+    } else if (event->button() == Qt::RightButton) {
+        m_panning = true;
+        m_lastPan = event->pos();
+        setCursor(Qt::ClosedHandCursor);
+        event->accept();
+    } else {
+        QChartView::mousePressEvent(event);
+    }
+}
+
+void HistoryChartView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (m_selecting) {
+        //Only the time span matters, so select the full plot height
+        const QRectF plot = chart()->plotArea();
+        const QPoint top = mapFromScene(chart()->mapToScene(plot.topLeft()));
+        const QPoint bottom = mapFromScene(chart()->mapToScene(plot.bottomLeft()));
+        m_rubberBand->setGeometry(QRect(QPoint(m_origin.x(), top.y()),
+                                        QPoint(event->pos().x(), bottom.y())).normalized());
+        event->accept();
+        return;
+    }
+    if (m_panning) {
+        qreal fromMs, toMs;
+        const qreal width = chart()->plotArea().width();
+        if (currentRange(fromMs, toMs) && width > 0) {
+            const qreal shift = (m_lastPan.x() - event->pos().x()) / width * (toMs - fromMs);
+            emit rangeRequested(qRound64(fromMs + shift), qRound64(toMs + shift));
+        }
+        m_lastPan = event->pos();
+        event->accept();
+        return;
+    }
+    QChartView::mouseMoveEvent(event);
+}
+
+void HistoryChartView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (m_selecting && event->button() == Qt::LeftButton) {
+        m_selecting = false;
+        m_rubberBand->hide();
+        qreal fromMs, toMs;
+        const qreal a = plotFraction(m_origin);
+        const qreal b = plotFraction(event->pos());
+        //A click without a drag is not a zoom request
+        if (qAbs(event->pos().x() - m_origin.x()) > 3 && currentRange(fromMs, toMs)) {
+            const qreal span = toMs - fromMs;
+            const qreal newFrom = fromMs + qMin(a, b) * span;
+            const qreal newTo = qMax(fromMs + qMax(a, b) * span, newFrom + MinimumSpanMs);
+            emit rangeRequested(qRound64(newFrom), qRound64(newTo));
+        }
+        event->accept();
+        return;
+    }
+    if (m_panning && event->button() == Qt::RightButton) {
+        m_panning = false;
+        unsetCursor();
+        event->accept();
+        return;
+    }
+    QChartView::mouseReleaseEvent(event);
+}
+
+void HistoryChartView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    emit followLiveRequested();
+    event->accept();
+}
+
+void HistoryChartView::wheelEvent(QWheelEvent *event)
+{
+    qreal fromMs, toMs;
+    if (!currentRange(fromMs, toMs)) {
+        QChartView::wheelEvent(event);
+        return;
+    }
+    //One notch (120) zooms by 20%, keeping the time under the cursor where it is
+    const qreal factor = qPow(0.8, event->angleDelta().y() / 120.0);
+    const qreal anchor = fromMs + plotFraction(event->pos()) * (toMs - fromMs);
+    const qreal newFrom = anchor - (anchor - fromMs) * factor;
+    const qreal newTo = qMax(anchor + (toMs - anchor) * factor, newFrom + MinimumSpanMs);
+    emit rangeRequested(qRound64(newFrom), qRound64(newTo));
+    event->accept();
+}
@@ -0,0 +1,49 @@
+/*
+ * Purpose: Chart view that turns mouse input into time range requests instead of letting
+ * QChart zoom its own axes, so the window can redraw the range from the history summaries.
+ *   left drag      rubber-band zoom to the selected span
+ *   wheel          zoom in/out around the cursor
+ *   right drag     pan
+ *   double click   go back to following live data
+ * */
+
+#ifndef HISTORYCHARTVIEW_H
+#define HISTORYCHARTVIEW_H
+
+#include <QChartView>
+
+QT_CHARTS_USE_NAMESPACE
+
+class QRubberBand;
+
+class HistoryChartView : public QChartView
+{
+    Q_OBJECT
+
+public:
+    explicit HistoryChartView(QWidget *parent = nullptr);
+
+signals:
+    void rangeRequested(qint64 fromMs, qint64 toMs);
+    void followLiveRequested();
+
+protected:
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+
+private:
+    bool currentRange(qreal &fromMs, qreal &toMs) const;
+    //Fraction of the plot width at pos, 0 at the left edge and 1 at the right
+    qreal plotFraction(const QPoint &pos) const;
+
+    QRubberBand *m_rubberBand;
+    QPoint m_origin;
+    QPoint m_lastPan;
+    bool m_selecting = false;
+    bool m_panning = false;
+};
+
+#endif // HISTORYCHARTVIEW_H
@@ -0,0 +1,125 @@
+#include "historyexporter.h"
+
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstdio>
+#include <cstring>
+
+//Flush to disk in 4 MiB writes
+static const int WriteBufferBytes = 4 * 1024 * 1024;
+//Samples per columnar chunk, 1 MiB of columns
+static const int ChunkSamples = 65536;
+
+HistoryExporter::HistoryExporter(const CompressedHistory &decoder, const QVector<CompressedBlock> &blocks,
+                                 qint64 fromNs, qint64 toNs, const QString &fileName, Format format) :
+    m_decoder(decoder.valueEncoding(), decoder.quantum()),
+    m_blocks(blocks), m_fromNs(fromNs), m_toNs(toNs), m_fileName(fileName), m_format(format),
+    m_cancelled(false)
+{
+}
+
+void HistoryExporter::run()
+{
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        emit finished(false, file.errorString());
+        return;
+    }
+
+    quint64 total = 0;
+    for (const CompressedBlock &block : m_blocks) {
+        if (block.lastTimeNs >= m_fromNs && block.firstTimeNs <= m_toNs)
+            total += block.count;
+    }
+
+    QByteArray buffer;
+    buffer.reserve(WriteBufferBytes + 4096);
+    bool writeFailed = false;
+    auto flush = [&]() {
+        if (!buffer.isEmpty() && file.write(buffer) != buffer.size())
+            writeFailed = true;
+        buffer.resize(0);
+    };
+
+    //Columnar chunks are gathered here, then appended column by column
+    QVector<qint64> times;
+    QVector<double> values;
+    auto flushChunk = [&]() {
+        if (times.isEmpty())
+            return;
+        const quint32 count = qToLittleEndian(quint32(times.size()));
+        buffer.append(reinterpret_cast<const char *>(&count), sizeof(count));
+        for (qint64 &t : times)
+            t = qToLittleEndian(t);
+        buffer.append(reinterpret_cast<const char *>(times.constData()), times.size() * int(sizeof(qint64)));
+        for (double v : values) {
+            quint64 bits;
+            memcpy(&bits, &v, sizeof(bits));
+            bits = qToLittleEndian(bits);
+            buffer.append(reinterpret_cast<const char *>(&bits), sizeof(bits));
+        }
+        times.resize(0);
+        values.resize(0);
+        if (buffer.size() >= WriteBufferBytes)
+            flush();
+    };
+
+    if (m_format == Csv) {
+        buffer.append("time_ns,celsius\n");
+    } else {
+        const quint32 header[2] = { qToLittleEndian(ColumnarFileMagic), qToLittleEndian(ColumnarFileVersion) };
+        buffer.append(reinterpret_cast<const char *>(header), sizeof(header));
+        times.reserve(ChunkSamples);
+        values.reserve(ChunkSamples);
+    }
+
+    quint64 done = 0;
+    quint64 exported = 0;
+    int lastPercent = -1;
+    char line[64];
+    for (const CompressedBlock &block : m_blocks) {
+        if (block.lastTimeNs < m_fromNs || block.firstTimeNs > m_toNs)
+            continue;
+        if (m_cancelled) {
+            file.cancelWriting();
+            emit finished(false, tr("Export cancelled"));
+            return;
+        }
+
+        m_decoder.decodeBlock(block, [&](qint64 timeNs, double value) {
+            if (timeNs < m_fromNs || timeNs > m_toNs)
+                return;
+            exported++;
+            if (m_format == Csv) {
+                //17 digits round trip any double, so the 1/128 C codes come back exactly
+                const int n = snprintf(line, sizeof(line), "%lld,%.17g\n", static_cast<long long>(timeNs), value);
+                buffer.append(line, n);
+            } else {
+                times.append(timeNs);
+                values.append(value);
+                if (times.size() == ChunkSamples)
+                    flushChunk();
+            }
+        });
+        if (m_format == Csv && buffer.size() >= WriteBufferBytes)
+            flush();
+        if (writeFailed)
+            break;
+
+        done += block.count;
+        const int percent = total ? int(done * 100 / total) : 100;
+        if (percent != lastPercent) {
+            lastPercent = percent;
+            emit progress(percent);
+        }
+    }
+    flushChunk();
+    flush();
+
+    if (writeFailed || !file.commit()) {
+        emit finished(false, file.errorString());
+        return;
+    }
+    emit finished(true, tr("Exported %1 samples to %2").arg(exported).arg(m_fileName));
+}
@@ -0,0 +1,59 @@
+/*
+ * Purpose: Writes a time range of the history to CSV or to a columnar binary file on a worker
+ * thread. It works from a snapshot of the compressed blocks (implicitly shared, so nothing is
+ * copied up front) and decodes one block at a time into a large write buffer, so exporting
+ * millions of points neither stalls the window nor needs them all in memory.
+ *
+ * Columnar binary (.tgc), little endian:
+ *   header  "TGHC" magic (u32), version (u32)
+ *   chunks  count (u32), then count timestamps (i64, ns since epoch), then count values (f64)
+ * */
+
+#ifndef HISTORYEXPORTER_H
+#define HISTORYEXPORTER_H
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+
+#include "compressedhistory.h"
+
+static const quint32 ColumnarFileMagic = 0x43484754; //"TGHC" read as little endian
+static const quint32 ColumnarFileVersion = 1;
+
+class HistoryExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Format {
+        Csv,
+        Columnar
+    };
+
+    //decoder only lends its encoding settings, it is never touched from the worker thread
+    HistoryExporter(const CompressedHistory &decoder, const QVector<CompressedBlock> &blocks,
+                    qint64 fromNs, qint64 toNs, const QString &fileName, Format format);
+
+    //Safe to call from any thread, the export stops at the next block
+    void cancel() { m_cancelled = true; }
+
+public slots:
+    void run();
+
+signals:
+    void progress(int percent);
+    void finished(bool ok, const QString &message);
+
+private:
+    CompressedHistory m_decoder;
+    QVector<CompressedBlock> m_blocks;
+    qint64 m_fromNs;
+    qint64 m_toNs;
+    QString m_fileName;
+    Format m_format;
+    std::atomic<bool> m_cancelled;
+};
+
+#endif // HISTORYEXPORTER_H
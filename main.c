@@ -32,21 +32,136 @@
 
 
 /*
- * Address for the ADT7420 Sensor
+ * Addresses an ADT7420 can be strapped to. All four are probed at start up
+ * and every sensor that answers is read in turn.
  */
-#define TEMP_SENSOR_ADDRESS	0x4B
+#define ADT7420_FIRST_ADDRESS	0x48
+#define ADT7420_LAST_ADDRESS	0x4B
+#define MAX_SENSORS		(ADT7420_LAST_ADDRESS - ADT7420_FIRST_ADDRESS + 1)
 
 #define TEST_BUFFER_SIZE    500
 #define LED_CHANNEL			1
 
+/*
+ * Report on change: only send a reading when it has moved more than
+ * DEADBAND_COUNTS (raw register counts, 8 counts is one LSB in 13 bit mode)
+ * from the last one sent, or when HEARTBEAT_MS milliseconds have gone by
+ * without a send so the monitor knows the board is still alive. The time
+ * comes from the free running AXI Timer (counter 0). The monitor must have
+ * "Report on change" ticked in its port settings to draw the flat stretches
+ * in between, and its Heartbeat set to the same period: after three missed
+ * heartbeats it stops holding the last value. It is off by default because
+ * the stock block design has no AXI Timer: add one as axi_timer_0 and build
+ * with REPORT_ON_CHANGE set to 1 to use it.
+ */
+#ifndef REPORT_ON_CHANGE
+#define REPORT_ON_CHANGE	0
+#endif
+#ifndef DEADBAND_COUNTS
+#define DEADBAND_COUNTS		8
+#endif
+#ifndef HEARTBEAT_MS
+#define HEARTBEAT_MS		1000
+#endif
+
+/*
+ * Wire format. WIRE_RAW16 sends each reading as its two register bytes, big
+ * endian. WIRE_DELTA packs up to DELTA_FRAME_READINGS readings per frame:
+ *
+ *   0xA5, (count - 1) << 2 | shift, counter (2 bytes, big endian),
+ *   first reading (2 bytes, big endian), count - 1 signed 4 bit deltas high
+ *   nibble first in units of 1 << shift, checksum (sum of every byte after
+ *   the 0xA5, mod 256)
+ *
+ * The counter numbers every reading so the monitor knows when each was taken
+ * and can count lost ones. A reading that is not a small step from the one
+ * before starts a new frame. Delta frames carry every reading, report on
+ * change only applies to WIRE_RAW16.
+ *
+ * WIRE_TAGGED carries every sensor on the bus, batching up to
+ * TAGGED_FRAME_SAMPLES readings per frame:
+ *
+ *   0xA6, count, counter of the first reading (2 bytes, big endian), then
+ *   count times: sensor (address - 0x48), reading (2 bytes, big endian),
+ *   then the checksum as above
+ *
+ * WIRE_RAW16 and WIRE_DELTA have no room for a sensor number, so they only
+ * read the first sensor found. The monitor's Wire format setting must match.
+ */
+#define WIRE_RAW16	0
+#define WIRE_DELTA	1
+#define WIRE_TAGGED	2
+#ifndef WIRE_FORMAT
+#define WIRE_FORMAT	WIRE_RAW16
+#endif
+
+/* Only report on change with WIRE_RAW16 needs the timer */
+#define HEARTBEAT_TIMER	(REPORT_ON_CHANGE && WIRE_FORMAT == WIRE_RAW16)
+#if HEARTBEAT_TIMER
+#include "xtmrctr.h"
+
+#define TMRCTR_DEVICE_ID		XPAR_TMRCTR_0_DEVICE_ID
+#define TIMER_COUNTER			0
+#define TIMER_COUNTS_PER_MS		(XPAR_TMRCTR_0_CLOCK_FREQ_HZ / 1000)
+
+/* The timer is 32 bits and read on every reading, so a period must fit in it */
+#if (HEARTBEAT_MS) * (TIMER_COUNTS_PER_MS) > 0xFFFFFFFF
+#error "HEARTBEAT_MS is longer than the AXI Timer can count"
+#endif
+#endif
+
+#define DELTA_SYNC				0xA5
+#define DELTA_FRAME_READINGS	64		/* at most 64, the count has 6 bits */
+#define DELTA_SHIFT				3		/* 13 bit mode, the low 3 bits are flags */
+#define DELTA_HEADER_BYTES		6
+#define DELTA_FRAME_BYTES		(DELTA_HEADER_BYTES + DELTA_FRAME_READINGS / 2 + 1)
+
+#define TAGGED_SYNC				0xA6
+#define TAGGED_FRAME_SAMPLES	32
+#define TAGGED_HEADER_BYTES		4
+#define TAGGED_SAMPLE_BYTES		3
+#define TAGGED_FRAME_BYTES		(TAGGED_HEADER_BYTES + \
+		TAGGED_FRAME_SAMPLES * TAGGED_SAMPLE_BYTES + 1)
+
+#if WIRE_FORMAT == WIRE_TAGGED
+#define TX_FRAME_BYTES	TAGGED_FRAME_BYTES
+#else
+#define TX_FRAME_BYTES	DELTA_FRAME_BYTES
+#endif
+
+/*
+ * Sample slots. The I2C reads into one slot while the reading in the other
+ * waits for, or goes out over, the UART.
+ */
+#define SAMPLE_SLOTS	2
+#define SLOT_FREE		0
+#define SLOT_READING	1	/* I2C transfer into it in progress */
+#define SLOT_READY		2	/* read finished, Valid says whether it worked */
+#define SLOT_SENDING	3	/* UART is sending straight out of it */
+
+#define FRAME_FREE		0	/* being filled, or empty */
+#define FRAME_QUEUED	1	/* complete, waiting for the UART */
+#define FRAME_SENDING	2
+
 
 /**************************** Type Definitions *******************************/
 
+typedef struct {
+	u8 Data[2];			/* temperature register, MSB first */
+	u8 Sensor;			/* index into SensorAddresses */
+	volatile int State;
+	volatile int Valid;
+} SampleSlot;
+
 /***************** Macros (Inline Functions) Definitions *********************/
 
 /************************** Function Prototypes ****************************/
 
-int SetupUartLite_IIC(u16 DeviceId, u16 IicDeviceId, u8 TempSensorAddress);
+int SetupUartLite_IIC(u16 DeviceId, u16 IicDeviceId);
+
+static int ScanSensors(void);
+
+static int ProbeSensor(u8 Address);
 
 static int SetupInterruptSystem(XIic *IicPtr, XUartLite *UartLitePtr);
 
@@ -60,6 +175,32 @@ void RecvHandlerUART(void *CallBackRef, unsigned int EventData);
 
 static int SevenSegValue(u32 LED_Value);
 
+#if WIRE_FORMAT == WIRE_RAW16
+static int ShouldSendReading(uint16_t Reading);
+#endif
+
+#if HEARTBEAT_TIMER
+static int SetupHeartbeatTimer(void);
+#endif
+
+static int HandleReading(int SlotIndex);
+
+#if WIRE_FORMAT == WIRE_DELTA
+static int QueueDeltaReading(uint16_t Reading);
+
+static void FinishDeltaFrame(void);
+#endif
+
+#if WIRE_FORMAT == WIRE_TAGGED
+static int QueueTaggedReading(u8 Sensor, uint16_t Reading);
+
+static void FinishTaggedFrame(void);
+#endif
+
+#if WIRE_FORMAT != WIRE_RAW16
+static void SendQueuedFrame(void);
+#endif
+
 
 /************************** Variable Definitions **************************/
 
@@ -70,6 +211,10 @@ XIntc InterruptController;  /* The instance of the Interrupt controller */
 XUartLite UartLite; //Instance of UartLite Device
 XUartLite_Config *UartLite_Cfg; //For configuration of UART
 
+#if HEARTBEAT_TIMER
+XTmrCtr HeartbeatTimer;	/* Free running, times the report on change heartbeat */
+#endif
+
 
 /*
  * The following structure contains fields that are used with the callbacks
@@ -99,15 +244,59 @@ u8* CommandPtr = &ReceiveBuffer[0];
 static volatile int TotalReceivedCount; //volatile is used so that values are not lost
 static volatile int TotalSentCount;
 
+#if WIRE_FORMAT == WIRE_RAW16
+/* Report on change state, see ShouldSendReading() */
+static uint16_t LastSentReading;
+#if HEARTBEAT_TIMER
+static u32 LastSendTicks;		/* HeartbeatTimer value at the last send */
+#endif
+static int SentAny;			/* FALSE until the first reading is sent */
+#endif
+
+/*
+ * Pipeline state. Slots are read and sent in turn; the handlers release a
+ * slot (or frame) and the busy flags, the main loop claims them.
+ */
+static SampleSlot SampleSlots[SAMPLE_SLOTS];
+static int NextReadSlot;
+static int NextSendSlot;
+static volatile int ReadingSlot = -1;	/* slot the I2C is filling, -1 if idle */
+static volatile int SendingSlot = -1;	/* slot the UART is sending, -1 if none */
+static volatile int UartBusy;
+static volatile int IicErrors;
+
+/* Sensors that answered the scan, read round robin */
+static u8 SensorAddresses[MAX_SENSORS];
+static int SensorCount;
+static int NextSensor;
+
+/*
+ * Delta and tagged frames are built in one buffer while the UART sends the
+ * other, so a frame is never changed under the driver.
+ */
+static volatile int TxFrameState[2];
+static volatile int SendingFrame = -1;
+#if WIRE_FORMAT != WIRE_RAW16
+static u8 TxFrames[2][TX_FRAME_BYTES];
+static int TxFrameLength[2];
+static int TxFrameIndex;			/* buffer being filled */
+static int NextSendFrame;			/* frames go out in the order finished */
+static u16 ReadingCounter;
+#endif
+#if WIRE_FORMAT == WIRE_DELTA
+static int DeltaCount;				/* readings in it so far */
+static uint16_t DeltaPrevious;
+#elif WIRE_FORMAT == WIRE_TAGGED
+static int TaggedCount;
+#endif
+
 int main(void)
 {
 	long i = 0;
 	int Status;
-	u8 TemperaturePtr[2];
-	uint16_t temp;
 
 	//Setup Uart
-	Status = SetupUartLite_IIC(UARTLITE_DEVICE_ID, IIC_DEVICE_ID, TEMP_SENSOR_ADDRESS);
+	Status = SetupUartLite_IIC(UARTLITE_DEVICE_ID, IIC_DEVICE_ID);
 	if (Status != XST_SUCCESS) {
 		//xil_printf("FAILURE UART OR IIC\n\r");
 		return XST_FAILURE;
@@ -117,56 +306,51 @@ int main(void)
 	UartLite_Cfg = XUartLite_LookupConfig(UARTLITE_DEVICE_ID);
 
 	/*
-	 * This is the event loop we should never return from
-	 * Here will will send out the temperature sensor every second
-	 * And display the approximate value in Celsius to the 7 Segment Display
+	 * This is the event loop we should never return from. It only starts
+	 * work, the I2C and UART interrupts finish it, so a read and a send are
+	 * always in flight together and the rate is set by the slower bus.
 	 */
 	while(i == 0)
 	{
-		for(int k = 0; k < 50000; k++){}
-		/*
-		* Clear updated flags such that they can be polled to indicate
-		* when the handler information has changed asynchronously and
-		* initialize the status which will be returned to a default value
-		*/
-	    HandlerInfo.EventStatusUpdated = FALSE;
-		HandlerInfo.RecvBytesUpdated = FALSE;
-		Status = XST_FAILURE;
-
 		/*
-		* Attempt to receive a byte of data from the temperature sensor
-		* on the IIC interface, ignore the return value since this example is
-		* a single master system such that the IIC bus should not ever be busy
-		*/
-		(void)XIic_MasterRecv(&Iic, TemperaturePtr, 2);
+		 * Start the next sensor read as soon as the I2C is idle and a
+		 * slot is free, whatever the UART is doing. The slot is claimed
+		 * before the transfer starts since the handler may run at once.
+		 */
+		if (ReadingSlot < 0 &&
+				SampleSlots[NextReadSlot].State == SLOT_FREE) {
+			SampleSlots[NextReadSlot].State = SLOT_READING;
+			SampleSlots[NextReadSlot].Sensor = (u8)NextSensor;
+			ReadingSlot = NextReadSlot;
+			XIic_SetAddress(&Iic, XII_ADDR_TO_SEND_TYPE,
+					SensorAddresses[NextSensor]);
+			Status = XIic_MasterRecv(&Iic, SampleSlots[NextReadSlot].Data, 2);
+			if (Status == XST_SUCCESS) {
+				NextReadSlot = (NextReadSlot + 1) % SAMPLE_SLOTS;
+				NextSensor = (NextSensor + 1) % SensorCount;
+			} else {
+				ReadingSlot = -1;
+				SampleSlots[NextReadSlot].State = SLOT_FREE;
+			}
+		}
 
 		/*
-		* The message is being received from the temperature sensor,
-		* wait for it to complete by polling the information that is
-		* updated asynchronously by interrupt processing
-		*/
-	    while(1)
-	    {
-	    	if(HandlerInfo.RecvBytesUpdated == TRUE) {
-	    		/*
-	    		 * The device information has been updated for receive
-	    		 * processing,if all bytes received (2), indicate
-	    		 * success
-	    		 */
-	    		if (HandlerInfo.RemainingRecvBytes == 0) {
-					Status = XST_SUCCESS;
+		 * Hand the oldest reading to the UART side, in the order they
+		 * were read. A failed read is just given back.
+		 */
+		if (SampleSlots[NextSendSlot].State == SLOT_READY) {
+			if (!SampleSlots[NextSendSlot].Valid ||
+					HandleReading(NextSendSlot)) {
+				if (SampleSlots[NextSendSlot].State == SLOT_READY) {
+					SampleSlots[NextSendSlot].State = SLOT_FREE;
 				}
-	    		break;
+				NextSendSlot = (NextSendSlot + 1) % SAMPLE_SLOTS;
 			}
-	    }
+		}
 
-	    //Check to make sure that we successfully received data
-	    if(Status == XST_SUCCESS)
-	    {
-	    	temp = (TemperaturePtr[0] << 8) | TemperaturePtr[1];
-	    	XUartLite_Send(&UartLite, (u8*)TemperaturePtr, 2);
-	    	//xil_printf("Value is: %d", temp);
-	    }
+#if WIRE_FORMAT != WIRE_RAW16
+		SendQueuedFrame();
+#endif
 	}
 	/*
 	 * Call the TempSensorExample.
@@ -202,7 +386,7 @@ int main(void)
  * working it may never return.
  *
  ****************************************************************************/
-int SetupUartLite_IIC(u16 DeviceId, u16 IicDeviceId, u8 TempSensorAddress) {
+int SetupUartLite_IIC(u16 DeviceId, u16 IicDeviceId) {
 	int Status;
 	int Index;
 	XIic_Config *ConfigPtr;	/* Pointer to configuration data */
@@ -257,7 +441,6 @@ int SetupUartLite_IIC(u16 DeviceId, u16 IicDeviceId, u8 TempSensorAddress) {
 	}
 
 	XIic_Start(&Iic);
-	XIic_SetAddress(&Iic, XII_ADDR_TO_SEND_TYPE, TempSensorAddress);
 
 	/*
 	 * Setup the handlers for the UartLite that will be called from the
@@ -283,11 +466,80 @@ int SetupUartLite_IIC(u16 DeviceId, u16 IicDeviceId, u8 TempSensorAddress) {
 		ReceiveBuffer[Index] = 0;
 	}
 
+#if HEARTBEAT_TIMER
+	Status = SetupHeartbeatTimer();
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+#endif
+
+	/*
+	 * Find the sensors, there is nothing to do without at least one
+	 */
+	if (ScanSensors() == 0) {
+		return XST_FAILURE;
+	}
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+ *
+ * Probes every ADT7420 address and fills SensorAddresses with the ones that
+ * answer. Only the first is kept unless the wire format can tell sensors
+ * apart.
+ *
+ * @param	None.
+ *
+ * @return	The number of sensors found.
+ *
+ * @note	Runs before the main loop, while the pipeline is still idle.
+ *
+ ****************************************************************************/
+static int ScanSensors(void)
+{
+	int Address;
+
+	SensorCount = 0;
+	for (Address = ADT7420_FIRST_ADDRESS; Address <= ADT7420_LAST_ADDRESS;
+			Address++) {
+		if (ProbeSensor((u8)Address) != XST_SUCCESS) {
+			continue;
+		}
+		SensorAddresses[SensorCount++] = (u8)Address;
+#if WIRE_FORMAT != WIRE_TAGGED
+		break;
+#endif
+	}
+	NextSensor = 0;
+	return SensorCount;
+}
+
+/*****************************************************************************/
+/**
+ *
+ * Reads the temperature register of one address and waits for the result.
+ *
+ * @param	Address is the 7 bit I2C address to try
+ *
+ * @return	XST_SUCCESS if a sensor answered, XST_FAILURE if the address
+ *		was not acknowledged or the read came up short.
+ *
+ * @note	None.
+ *
+ ****************************************************************************/
+static int ProbeSensor(u8 Address)
+{
+	int Status;
+
+	XIic_SetAddress(&Iic, XII_ADDR_TO_SEND_TYPE, Address);
+
 	/*
 	* Clear updated flags such that they can be polled to indicate
 	* when the handler information has changed asynchronously and
 	* initialize the status which will be returned to a default value
 	*/
+	HandlerInfo.EventStatus = 0;
 	HandlerInfo.EventStatusUpdated = FALSE;
 	HandlerInfo.RecvBytesUpdated = FALSE;
 	Status = XST_FAILURE;
@@ -320,8 +572,8 @@ int SetupUartLite_IIC(u16 DeviceId, u16 IicDeviceId, u8 TempSensorAddress) {
 
 		/*
 		* Any event status which occurs indicates there was an error,
-		* so return unsuccessful, for this example there should be no
-		* status events since there is a single master on the bus
+		* so return unsuccessful, normally a NACK because no sensor is
+		* strapped to this address
 		*/
 		if (HandlerInfo.EventStatusUpdated == TRUE) {
 			break;
@@ -445,6 +697,13 @@ static void RecvHandlerIIC(void *CallbackRef, int ByteCount)
 {
 	HandlerInfo.RemainingRecvBytes = ByteCount;
 	HandlerInfo.RecvBytesUpdated = TRUE;
+
+	/* Pass the slot on to the UART side, the main loop starts the next read */
+	if (ReadingSlot >= 0) {
+		SampleSlots[ReadingSlot].Valid = (ByteCount == 0);
+		SampleSlots[ReadingSlot].State = SLOT_READY;
+		ReadingSlot = -1;
+	}
 }
 
 /*****************************************************************************/
@@ -466,6 +725,14 @@ static void StatusHandlerIIC(void *CallbackRef, int Status)
 {
 	HandlerInfo.EventStatus |= Status;
 	HandlerInfo.EventStatusUpdated = TRUE;
+
+	/* The read failed, the slot goes on empty so the order is kept */
+	if (ReadingSlot >= 0) {
+		IicErrors++;
+		SampleSlots[ReadingSlot].Valid = FALSE;
+		SampleSlots[ReadingSlot].State = SLOT_READY;
+		ReadingSlot = -1;
+	}
 }
 
 
@@ -492,6 +759,17 @@ static void StatusHandlerIIC(void *CallbackRef, int Status)
  ****************************************************************************/
 void SendHandlerUART(void *CallBackRef, unsigned int EventData) {
 	TotalSentCount = EventData;
+
+	/* Whatever was going out has gone, its buffer can be reused */
+	if (SendingSlot >= 0) {
+		SampleSlots[SendingSlot].State = SLOT_FREE;
+		SendingSlot = -1;
+	}
+	if (SendingFrame >= 0) {
+		TxFrameState[SendingFrame] = FRAME_FREE;
+		SendingFrame = -1;
+	}
+	UartBusy = FALSE;
 }
 
 /****************************************************************************/
@@ -532,6 +810,317 @@ void RecvHandlerUART(void *CallBackRef, unsigned int EventData) {
 
 }
 
+#if WIRE_FORMAT == WIRE_RAW16
+/*****************************************************************************/
+/**
+ *
+ * Decides whether a reading goes out over the UART. With REPORT_ON_CHANGE
+ * off every reading is sent, otherwise only readings that left the deadband
+ * around the last one sent, plus a heartbeat every HEARTBEAT_MS.
+ *
+ * @param	Reading is the raw 16 bit temperature register value
+ *
+ * @return	1 if the reading should be sent, 0 if it is dropped
+ *
+ * @note	The deadband is measured from the last value sent, not the last
+ *		value read, so a slow drift still gets through once it adds up.
+ *
+ ****************************************************************************/
+static int ShouldSendReading(uint16_t Reading)
+{
+#if REPORT_ON_CHANGE
+	int Delta = (int16_t)Reading - (int16_t)LastSentReading;
+	u32 Now = XTmrCtr_GetValue(&HeartbeatTimer, TIMER_COUNTER);
+
+	/* Unsigned difference, right across the counter wrapping */
+	if (SentAny && Delta <= DEADBAND_COUNTS && Delta >= -DEADBAND_COUNTS &&
+			Now - LastSendTicks <
+			(u32)HEARTBEAT_MS * TIMER_COUNTS_PER_MS) {
+		return 0;
+	}
+	LastSendTicks = Now;
+#endif
+	LastSentReading = Reading;
+	SentAny = TRUE;
+	return 1;
+}
+#endif
+
+#if HEARTBEAT_TIMER
+/*****************************************************************************/
+/**
+ *
+ * Starts counter 0 of the AXI Timer free running, counting up from zero and
+ * wrapping, as the time base for the report on change heartbeat.
+ *
+ * @param	None.
+ *
+ * @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+ *
+ * @note	No interrupt is used, ShouldSendReading() reads the counter.
+ *
+ ****************************************************************************/
+static int SetupHeartbeatTimer(void)
+{
+	int Status;
+
+	Status = XTmrCtr_Initialize(&HeartbeatTimer, TMRCTR_DEVICE_ID);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	XTmrCtr_SetOptions(&HeartbeatTimer, TIMER_COUNTER,
+			XTC_AUTO_RELOAD_OPTION);
+	XTmrCtr_SetResetValue(&HeartbeatTimer, TIMER_COUNTER, 0);
+	XTmrCtr_Start(&HeartbeatTimer, TIMER_COUNTER);
+	return XST_SUCCESS;
+}
+#endif
+
+/*****************************************************************************/
+/**
+ *
+ * Passes a finished reading on in the current wire format.
+ *
+ * @param	SlotIndex is the slot holding the reading
+ *
+ * @return	TRUE if the slot has been dealt with, FALSE if the UART side
+ *		cannot take it yet and it should be offered again later.
+ *
+ * @note	For WIRE_RAW16 the UART sends straight out of the slot, which
+ *		stays SLOT_SENDING until SendHandlerUART() frees it.
+ *
+ ****************************************************************************/
+static int HandleReading(int SlotIndex)
+{
+	SampleSlot *Slot = &SampleSlots[SlotIndex];
+	uint16_t Reading = (Slot->Data[0] << 8) | Slot->Data[1];
+
+#if WIRE_FORMAT == WIRE_DELTA
+	return QueueDeltaReading(Reading);
+#elif WIRE_FORMAT == WIRE_TAGGED
+	return QueueTaggedReading(
+			SensorAddresses[Slot->Sensor] - ADT7420_FIRST_ADDRESS, Reading);
+#else
+	if (UartBusy) {
+		return FALSE;
+	}
+	if (ShouldSendReading(Reading)) {
+		Slot->State = SLOT_SENDING;
+		SendingSlot = SlotIndex;
+		UartBusy = TRUE;
+		XUartLite_Send(&UartLite, Slot->Data, 2);
+	}
+	return TRUE;
+#endif
+}
+
+#if WIRE_FORMAT == WIRE_DELTA
+/*****************************************************************************/
+/**
+ *
+ * Adds a reading to the delta frame being built, finishing the frame when it
+ * is full or when the reading cannot be written as a delta from the one
+ * before (a step of more than 7 LSB, or different flag bits).
+ *
+ * @param	Reading is the raw 16 bit temperature register value
+ *
+ * @return	TRUE if the reading was taken, FALSE if both frame buffers are
+ *		waiting on the UART.
+ *
+ * @note	None.
+ *
+ ****************************************************************************/
+static int QueueDeltaReading(uint16_t Reading)
+{
+	u8 *Frame = TxFrames[TxFrameIndex];
+	int Delta = (int16_t)(Reading - DeltaPrevious);
+	int Step = Delta / (1 << DELTA_SHIFT);
+
+	if (TxFrameState[TxFrameIndex] != FRAME_FREE) {
+		return FALSE;
+	}
+
+	if (DeltaCount > 0 && Step * (1 << DELTA_SHIFT) == Delta &&
+			Step >= -8 && Step <= 7) {
+		int Slot = DeltaCount - 1;
+		u8 Nibble = (u8)(Step & 0x0F);
+
+		if (Slot & 1) {
+			Frame[DELTA_HEADER_BYTES + Slot / 2] |= Nibble;
+		} else {
+			Frame[DELTA_HEADER_BYTES + Slot / 2] = (u8)(Nibble << 4);
+		}
+		DeltaCount++;
+	} else {
+		if (DeltaCount > 0) {
+			FinishDeltaFrame();
+			if (TxFrameState[TxFrameIndex] != FRAME_FREE) {
+				/* Offered again later, it starts the next frame then */
+				return FALSE;
+			}
+			Frame = TxFrames[TxFrameIndex];
+		}
+		Frame[2] = (u8)(ReadingCounter >> 8);
+		Frame[3] = (u8)(ReadingCounter & 0xFF);
+		Frame[4] = (u8)(Reading >> 8);
+		Frame[5] = (u8)(Reading & 0xFF);
+		DeltaCount = 1;
+	}
+
+	DeltaPrevious = Reading;
+	ReadingCounter++;
+	if (DeltaCount == DELTA_FRAME_READINGS) {
+		FinishDeltaFrame();
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+/**
+ *
+ * Completes the header and checksum of the delta frame being built, queues
+ * it for the UART and moves on to the other buffer.
+ *
+ * @param	None.
+ *
+ * @return	None.
+ *
+ * @note	None.
+ *
+ ****************************************************************************/
+static void FinishDeltaFrame(void)
+{
+	u8 *Frame = TxFrames[TxFrameIndex];
+	int Length = DELTA_HEADER_BYTES + DeltaCount / 2;
+	u8 Sum = 0;
+	int Index;
+
+	Frame[0] = DELTA_SYNC;
+	Frame[1] = (u8)(((DeltaCount - 1) << 2) | DELTA_SHIFT);
+	for (Index = 1; Index < Length; Index++) {
+		Sum += Frame[Index];
+	}
+	Frame[Length] = Sum;
+
+	TxFrameLength[TxFrameIndex] = Length + 1;
+	TxFrameState[TxFrameIndex] = FRAME_QUEUED;
+	TxFrameIndex ^= 1;
+	DeltaCount = 0;
+}
+#endif
+
+#if WIRE_FORMAT == WIRE_TAGGED
+/*****************************************************************************/
+/**
+ *
+ * Adds a reading to the tagged frame being built, finishing the frame when
+ * it is full.
+ *
+ * @param	Sensor is the sensor number sent with it, address - 0x48
+ * @param	Reading is the raw 16 bit temperature register value
+ *
+ * @return	TRUE if the reading was taken, FALSE if both frame buffers are
+ *		waiting on the UART.
+ *
+ * @note	None.
+ *
+ ****************************************************************************/
+static int QueueTaggedReading(u8 Sensor, uint16_t Reading)
+{
+	u8 *Frame = TxFrames[TxFrameIndex];
+	u8 *Sample;
+
+	if (TxFrameState[TxFrameIndex] != FRAME_FREE) {
+		return FALSE;
+	}
+
+	if (TaggedCount == 0) {
+		Frame[2] = (u8)(ReadingCounter >> 8);
+		Frame[3] = (u8)(ReadingCounter & 0xFF);
+	}
+	Sample = &Frame[TAGGED_HEADER_BYTES + TaggedCount * TAGGED_SAMPLE_BYTES];
+	Sample[0] = Sensor;
+	Sample[1] = (u8)(Reading >> 8);
+	Sample[2] = (u8)(Reading & 0xFF);
+	TaggedCount++;
+	ReadingCounter++;
+
+	if (TaggedCount == TAGGED_FRAME_SAMPLES) {
+		FinishTaggedFrame();
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+/**
+ *
+ * Completes the header and checksum of the tagged frame being built, queues
+ * it for the UART and moves on to the other buffer.
+ *
+ * @param	None.
+ *
+ * @return	None.
+ *
+ * @note	None.
+ *
+ ****************************************************************************/
+static void FinishTaggedFrame(void)
+{
+	u8 *Frame = TxFrames[TxFrameIndex];
+	int Length = TAGGED_HEADER_BYTES + TaggedCount * TAGGED_SAMPLE_BYTES;
+	u8 Sum = 0;
+	int Index;
+
+	Frame[0] = TAGGED_SYNC;
+	Frame[1] = (u8)TaggedCount;
+	for (Index = 1; Index < Length; Index++) {
+		Sum += Frame[Index];
+	}
+	Frame[Length] = Sum;
+
+	TxFrameLength[TxFrameIndex] = Length + 1;
+	TxFrameState[TxFrameIndex] = FRAME_QUEUED;
+	TxFrameIndex ^= 1;
+	TaggedCount = 0;
+}
+#endif
+
+#if WIRE_FORMAT != WIRE_RAW16
+/*****************************************************************************/
+/**
+ *
+ * Starts sending the oldest queued frame if the UART is free.
+ *
+ * @param	None.
+ *
+ * @return	None.
+ *
+ * @note	SendHandlerUART() frees the frame buffer when it has gone. A
+ *		tagged frame does not wait to fill up when the UART would
+ *		otherwise sit idle, once it holds a reading from every sensor it
+ *		goes, so frames grow with the load and stay small when it is light.
+ *
+ ****************************************************************************/
+static void SendQueuedFrame(void)
+{
+#if WIRE_FORMAT == WIRE_TAGGED
+	if (!UartBusy && TaggedCount >= SensorCount &&
+			TxFrameState[NextSendFrame] != FRAME_QUEUED) {
+		FinishTaggedFrame();
+	}
+#endif
+	if (UartBusy || TxFrameState[NextSendFrame] != FRAME_QUEUED) {
+		return;
+	}
+	TxFrameState[NextSendFrame] = FRAME_SENDING;
+	SendingFrame = NextSendFrame;
+	UartBusy = TRUE;
+	XUartLite_Send(&UartLite, TxFrames[NextSendFrame],
+			TxFrameLength[NextSendFrame]);
+	NextSendFrame ^= 1;
+}
+#endif
+
 /*****************************************************************************/
 /**
  *
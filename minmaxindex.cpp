@@ -0,0 +1,70 @@
+#include "minmaxindex.h"
+
+#include <limits>
+
+static const double Infinity = std::numeric_limits<double>::infinity();
+
+void MinMaxIndex::clear()
+{
+    m_size = 0;
+    m_capacity = 0;
+    m_min.clear();
+    m_max.clear();
+}
+
+void MinMaxIndex::pull(int node)
+{
+    m_min[node] = qMin(m_min[2 * node], m_min[2 * node + 1]);
+    m_max[node] = qMax(m_max[2 * node], m_max[2 * node + 1]);
+}
+
+void MinMaxIndex::grow()
+{
+    const int capacity = m_capacity ? m_capacity * 2 : 64;
+    QVector<double> mins(2 * capacity, Infinity);
+    QVector<double> maxs(2 * capacity, -Infinity);
+    for (int i = 0; i < m_size; i++) {
+        mins[capacity + i] = m_min[m_capacity + i];
+        maxs[capacity + i] = m_max[m_capacity + i];
+    }
+    m_min.swap(mins);
+    m_max.swap(maxs);
+    m_capacity = capacity;
+    for (int node = capacity - 1; node > 0; node--)
+        pull(node);
+}
+
+void MinMaxIndex::append(double min, double max)
+{
+    if (m_size == m_capacity)
+        grow();
+    update(m_size++, min, max);
+}
+
+void MinMaxIndex::update(int leaf, double min, double max)
+{
+    int node = m_capacity + leaf;
+    m_min[node] = min;
+    m_max[node] = max;
+    for (node /= 2; node > 0; node /= 2)
+        pull(node);
+}
+
+void MinMaxIndex::query(int first, int last, double &min, double &max) const
+{
+    min = Infinity;
+    max = -Infinity;
+    //Bottom-up walk over the half open leaf range [first, last + 1)
+    for (int l = first + m_capacity, r = last + 1 + m_capacity; l < r; l /= 2, r /= 2) {
+        if (l & 1) {
+            min = qMin(min, m_min[l]);
+            max = qMax(max, m_max[l]);
+            l++;
+        }
+        if (r & 1) {
+            r--;
+            min = qMin(min, m_min[r]);
+            max = qMax(max, m_max[r]);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+/*
+ * Purpose: Append-only segment tree of min/max over a growing list of leaves.
+ * CompressedHistory keeps one leaf per block so the min/max of any block range is
+ * answered in O(log n) instead of walking every block.
+ * */
+
+#ifndef MINMAXINDEX_H
+#define MINMAXINDEX_H
+
+#include <QVector>
+#include <QtGlobal>
+
+class MinMaxIndex
+{
+public:
+    void clear();
+    int size() const { return m_size; }
+
+    void append(double min, double max);
+    //Replaces the bounds of an existing leaf, used while the open block is still growing
+    void update(int leaf, double min, double max);
+
+    //Min/max over leaves first..last inclusive, both must be valid leaves
+    void query(int first, int last, double &min, double &max) const;
+
+private:
+    void grow();
+    void pull(int node);
+
+    int m_size = 0;
+    int m_capacity = 0;         //leaves the tree has room for, a power of two
+    QVector<double> m_min;      //heap layout, node 1 is the root, leaves start at m_capacity
+    QVector<double> m_max;
+};
+
+#endif // MINMAXINDEX_H
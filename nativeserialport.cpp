@@ -0,0 +1,260 @@
+#include "nativeserialport.h"
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+//256 KiB of chunks, several seconds of data at 4 Mbaud before the reader has to wait on the GUI
+static const int ChunkCount = 64;
+
+NativeSerialPort::NativeSerialPort(const SampleClock &clock, QObject *parent) :
+    QObject(parent), m_clock(clock), m_thread(this),
+    m_head(0), m_tail(0), m_drainQueued(false), m_stalls(0)
+{
+}
+
+NativeSerialPort::~NativeSerialPort()
+{
+    close();
+}
+
+bool NativeSerialPort::isAvailable()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef Q_OS_LINUX
+
+static speed_t toSpeed(qint32 baudRate)
+{
+    switch (baudRate) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 500000: return B500000;
+    case 576000: return B576000;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 1152000: return B1152000;
+    case 1500000: return B1500000;
+    case 2000000: return B2000000;
+    case 2500000: return B2500000;
+    case 3000000: return B3000000;
+    case 3500000: return B3500000;
+    case 4000000: return B4000000;
+    default: return B0;
+    }
+}
+
+bool NativeSerialPort::open(const SettingsDialog::Settings &settings, bool lowLatency)
+{
+    close();
+
+    const speed_t speed = toSpeed(settings.baudRate);
+    if (speed == B0) {
+        m_errorString = tr("The native reader does not support %1 baud").arg(settings.baudRate);
+        return false;
+    }
+
+    const QString path = settings.name.startsWith('/') ? settings.name : QStringLiteral("/dev/") + settings.name;
+    m_fd = ::open(path.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        m_errorString = tr("%1: %2").arg(path).arg(QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+
+    termios tio;
+    if (tcgetattr(m_fd, &tio) != 0) {
+        m_errorString = tr("%1 is not a serial port").arg(path);
+        close();
+        return false;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS);
+    switch (settings.dataBits) {
+    case QSerialPort::Data5: tio.c_cflag |= CS5; break;
+    case QSerialPort::Data6: tio.c_cflag |= CS6; break;
+    case QSerialPort::Data7: tio.c_cflag |= CS7; break;
+    default: tio.c_cflag |= CS8; break;
+    }
+    if (settings.parity == QSerialPort::EvenParity)
+        tio.c_cflag |= PARENB;
+    else if (settings.parity == QSerialPort::OddParity)
+        tio.c_cflag |= PARENB | PARODD;
+    if (settings.stopBits == QSerialPort::TwoStop)
+        tio.c_cflag |= CSTOPB;
+    if (settings.flowControl == QSerialPort::HardwareControl)
+        tio.c_cflag |= CRTSCTS;
+    else if (settings.flowControl == QSerialPort::SoftwareControl)
+        tio.c_iflag |= IXON | IXOFF;
+    //epoll does the waiting, so reads return whatever is there rather than waiting for VMIN bytes
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(m_fd, TCSANOW, &tio) != 0) {
+        m_errorString = tr("Could not configure %1: %2").arg(path).arg(QString::fromLocal8Bit(strerror(errno)));
+        close();
+        return false;
+    }
+    tcflush(m_fd, TCIFLUSH);
+
+    m_lowLatencyApplied = false;
+    if (lowLatency) {
+        serial_struct serial;
+        if (ioctl(m_fd, TIOCGSERIAL, &serial) == 0) {
+            serial.flags |= ASYNC_LOW_LATENCY;
+            m_lowLatencyApplied = ioctl(m_fd, TIOCSSERIAL, &serial) == 0;
+        }
+    }
+
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = m_fd;
+    const bool watched = m_epollFd >= 0 && m_wakeFd >= 0 && epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_fd, &event) == 0;
+    event.data.fd = m_wakeFd;
+    if (!watched || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event) != 0) {
+        m_errorString = tr("epoll: %1").arg(QString::fromLocal8Bit(strerror(errno)));
+        close();
+        return false;
+    }
+
+    //Allocated once here, the reader never allocates
+    m_chunks.resize(ChunkCount);
+    m_head = 0;
+    m_tail = 0;
+    m_drainQueued = false;
+    m_stalls = 0;
+    m_errorString.clear();
+    m_thread.start(lowLatency ? QThread::TimeCriticalPriority : QThread::HighPriority);
+    return true;
+}
+
+void NativeSerialPort::close()
+{
+    if (m_thread.isRunning()) {
+        const quint64 one = 1;
+        if (::write(m_wakeFd, &one, sizeof(one)) < 0)
+            qWarning("NativeSerialPort: could not wake the reader");
+        m_thread.wait();
+    }
+    for (int *fd : { &m_wakeFd, &m_epollFd, &m_fd }) {
+        if (*fd >= 0)
+            ::close(*fd);
+        *fd = -1;
+    }
+}
+
+void NativeSerialPort::readLoop()
+{
+    epoll_event events[2];
+    for (;;) {
+        const int ready = epoll_wait(m_epollFd, events, 2, -1);
+        if (ready < 0) {
+            if (errno == EINTR)
+                continue;
+            QMetaObject::invokeMethod(this, "reportError", Qt::QueuedConnection,
+                                      Q_ARG(QString, QString::fromLocal8Bit(strerror(errno))));
+            return;
+        }
+        //Stamp before reading, this is as close to arrival as user space gets
+        const qint64 readNs = m_clock.nowNs();
+        for (int i = 0; i < ready; i++) {
+            if (events[i].data.fd == m_wakeFd)
+                return;
+            if (events[i].events & (EPOLLERR | EPOLLHUP) && !(events[i].events & EPOLLIN)) {
+                QMetaObject::invokeMethod(this, "reportError", Qt::QueuedConnection,
+                                          Q_ARG(QString, tr("The serial device went away")));
+                return;
+            }
+        }
+
+        //Empty the tty into as many chunks as it takes
+        for (;;) {
+            const quint32 head = m_head.load(std::memory_order_relaxed);
+            if (head - m_tail.load(std::memory_order_acquire) == quint32(m_chunks.size())) {
+                //The GUI is behind, leave the bytes in the kernel buffer and give it a moment
+                m_stalls++;
+                QThread::usleep(1000);
+                break;
+            }
+            Chunk &chunk = m_chunks[head % m_chunks.size()];
+            const ssize_t got = ::read(m_fd, chunk.data, sizeof(chunk.data));
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got <= 0) {
+                if (got < 0 && errno != EAGAIN) {
+                    QMetaObject::invokeMethod(this, "reportError", Qt::QueuedConnection,
+                                              Q_ARG(QString, QString::fromLocal8Bit(strerror(errno))));
+                    return;
+                }
+                break;
+            }
+            chunk.readNs = readNs;
+            chunk.size = int(got);
+            m_head.store(head + 1, std::memory_order_release);
+            //One queued call per batch, however many chunks land before the GUI gets to it
+            if (!m_drainQueued.exchange(true))
+                QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+            if (got < ssize_t(sizeof(chunk.data)))
+                break;
+        }
+    }
+}
+
+#else
+
+bool NativeSerialPort::open(const SettingsDialog::Settings &settings, bool lowLatency)
+{
+    Q_UNUSED(settings)
+    Q_UNUSED(lowLatency)
+    m_errorString = tr("The native reader is only available on Linux");
+    return false;
+}
+
+void NativeSerialPort::close()
+{
+}
+
+void NativeSerialPort::readLoop()
+{
+}
+
+#endif
+
+void NativeSerialPort::drain()
+{
+    //Clear first, a chunk published after this queues another drain rather than being missed
+    m_drainQueued = false;
+    quint32 tail = m_tail.load(std::memory_order_relaxed);
+    while (tail != m_head.load(std::memory_order_acquire)) {
+        const Chunk &chunk = m_chunks[tail % m_chunks.size()];
+        emit dataReceived(chunk.data, chunk.size, chunk.readNs);
+        m_tail.store(++tail, std::memory_order_release);
+    }
+}
+
+void NativeSerialPort::reportError(const QString &message)
+{
+    m_errorString = message;
+    emit errorOccurred(message);
+}
@@ -0,0 +1,89 @@
+/*
+ * Purpose: Linux serial reader that bypasses QSerialPort. A reader thread waits on the tty with
+ * epoll, stamps each read from the SampleClock the moment it wakes, and reads straight into a
+ * ring of preallocated chunks. The GUI thread is poked once per batch and hands each chunk to
+ * dataReceived() in place, so bytes are never copied between the kernel and the decoder.
+ *
+ * Low latency mode also sets ASYNC_LOW_LATENCY on the port (USB serial drivers flush their
+ * receive buffer straight away instead of on a timer) and runs the reader at time critical priority.
+ * */
+
+#ifndef NATIVESERIALPORT_H
+#define NATIVESERIALPORT_H
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+
+#include <atomic>
+#include <vector>
+
+#include "sampleclock.h"
+#include "settingsdialog.h"
+
+class NativeSerialPort : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NativeSerialPort(const SampleClock &clock, QObject *parent = nullptr);
+    ~NativeSerialPort();
+
+    //Only Linux has a native reader, elsewhere open() always fails
+    static bool isAvailable();
+
+    bool open(const SettingsDialog::Settings &settings, bool lowLatency);
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+    QString errorString() const { return m_errorString; }
+
+    //True when the driver accepted ASYNC_LOW_LATENCY, ptys and some adapters don't
+    bool lowLatencyApplied() const { return m_lowLatencyApplied; }
+    //Times the reader found every chunk still waiting for the GUI and had to back off
+    quint64 stalls() const { return m_stalls; }
+
+signals:
+    //data is only valid for the duration of the call
+    void dataReceived(const char *data, int size, qint64 readNs);
+    void errorOccurred(const QString &message);
+
+private slots:
+    void drain();
+    void reportError(const QString &message);
+
+private:
+    class ReaderThread : public QThread
+    {
+    public:
+        explicit ReaderThread(NativeSerialPort *port) : m_port(port) {}
+    protected:
+        void run() override { m_port->readLoop(); }
+    private:
+        NativeSerialPort *m_port;
+    };
+
+    struct Chunk {
+        qint64 readNs;
+        int size;
+        char data[4096];
+    };
+
+    void readLoop();
+
+    const SampleClock &m_clock;
+    ReaderThread m_thread;
+    int m_fd = -1;
+    int m_epollFd = -1;
+    int m_wakeFd = -1;              //eventfd that tells the reader to stop
+    bool m_lowLatencyApplied = false;
+    QString m_errorString;
+
+    //Single producer (reader thread), single consumer (GUI thread) ring, indices only grow
+    std::vector<Chunk> m_chunks;
+    std::atomic<quint32> m_head;
+    std::atomic<quint32> m_tail;
+    std::atomic<bool> m_drainQueued;
+    std::atomic<quint64> m_stalls;
+};
+
+#endif // NATIVESERIALPORT_H
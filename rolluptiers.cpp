@@ -0,0 +1,103 @@
+#include "rolluptiers.h"
+
+#include <algorithm>
+
+static const qint64 NsPerSecond = 1000000000LL;
+static const qint64 NsPerHour = 3600 * NsPerSecond;
+
+static inline qint64 bucketStart(qint64 timeNs, qint64 widthNs)
+{
+    const qint64 r = timeNs % widthNs;
+    return timeNs - (r < 0 ? r + widthNs : r);
+}
+
+RollupTiers::RollupTiers()
+{
+    //Finer tiers only keep as much as anyone zooms into, older data comes from coarser tiers
+    m_tiers.append(Tier{NsPerSecond, 48 * NsPerHour, QVector<RollupBucket>()});
+    m_tiers.append(Tier{60 * NsPerSecond, 90 * 24 * NsPerHour, QVector<RollupBucket>()});
+    m_tiers.append(Tier{NsPerHour, 0, QVector<RollupBucket>()});
+}
+
+void RollupTiers::append(qint64 timeNs, double value)
+{
+    for (Tier &tier : m_tiers) {
+        const qint64 start = bucketStart(timeNs, tier.widthNs);
+        if (!tier.buckets.isEmpty() && tier.buckets.last().startNs >= start) {
+            //Same bucket (or a late sample, which is folded into the newest bucket)
+            RollupBucket &b = tier.buckets.last();
+            b.min = qMin(b.min, value);
+            b.max = qMax(b.max, value);
+            b.sum += value;
+            b.count++;
+            continue;
+        }
+        tier.buckets.append(RollupBucket{start, value, value, value, 1});
+        trim(tier);
+    }
+}
+
+void RollupTiers::hold(qint64 fromNs, qint64 toNs, double value)
+{
+    const qint64 widthNs = m_tiers.first().widthNs;
+    //A hold longer than the finest tier keeps is a dead link rather than a steady reading
+    toNs = qMin(toNs, fromNs + m_tiers.first().retentionNs);
+    for (qint64 t = bucketStart(fromNs, widthNs) + widthNs; t < toNs; t += widthNs)
+        append(t, value);
+}
+
+void RollupTiers::clear()
+{
+    for (Tier &tier : m_tiers)
+        tier.buckets.clear();
+}
+
+void RollupTiers::trim(Tier &tier)
+{
+    if (tier.retentionNs == 0 || tier.buckets.size() < 2)
+        return;
+    const qint64 horizon = tier.buckets.last().startNs - tier.retentionNs;
+    //Drop in chunks of a quarter of the retention so the front erase is amortised
+    if (tier.buckets.first().startNs >= horizon - tier.retentionNs / 4)
+        return;
+    const auto keep = std::lower_bound(tier.buckets.begin(), tier.buckets.end(), horizon,
+                                       [](const RollupBucket &b, qint64 t) { return b.startNs < t; });
+    tier.buckets.erase(tier.buckets.begin(), keep);
+}
+
+qint64 RollupTiers::tierStartNs(int tier) const
+{
+    const QVector<RollupBucket> &b = m_tiers.at(tier).buckets;
+    return b.isEmpty() ? 0 : b.first().startNs;
+}
+
+int RollupTiers::pickTier(qint64 fromNs, qint64 toNs, int pixels) const
+{
+    if (pixels <= 0 || toNs <= fromNs)
+        return RawTier;
+    const qint64 nsPerPixel = (toNs - fromNs) / pixels;
+    for (int i = m_tiers.size() - 1; i >= 0; i--) {
+        //Pixel accurate and still covering the start of the range
+        if (m_tiers.at(i).widthNs <= nsPerPixel && tierStartNs(i) <= fromNs)
+            return i;
+    }
+    if (nsPerPixel < m_tiers.first().widthNs)
+        return RawTier;
+    //The fine enough tiers were trimmed back past fromNs, a slightly coarse tier
+    //beats decoding hours of raw samples
+    for (int i = 0; i < m_tiers.size(); i++) {
+        if (tierStartNs(i) <= fromNs)
+            return i;
+    }
+    return m_tiers.size() - 1;
+}
+
+void RollupTiers::buckets(int tier, qint64 fromNs, qint64 toNs, QVector<RollupBucket> &out) const
+{
+    out.clear();
+    const Tier &t = m_tiers.at(tier);
+    auto it = std::lower_bound(t.buckets.begin(), t.buckets.end(), fromNs - t.widthNs + 1,
+                               [](const RollupBucket &b, qint64 time) { return b.startNs < time; });
+    for (; it != t.buckets.end() && it->startNs <= toNs; ++it)
+        out.append(*it);
+}
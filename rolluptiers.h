@@ -0,0 +1,62 @@
+/*
+ * Purpose: Downsampled copies of the history (1 s, 1 min and 1 h buckets of min/max/mean/count)
+ * kept up to date as samples arrive, so drawing a month costs about the same as drawing a minute.
+ * The chart asks pickTier() for the coarsest tier whose buckets are still no wider than a pixel
+ * and only falls back to the raw samples when zoomed in closer than one bucket per pixel.
+ * */
+
+#ifndef ROLLUPTIERS_H
+#define ROLLUPTIERS_H
+
+#include <QVector>
+#include <QtGlobal>
+
+struct RollupBucket
+{
+    qint64 startNs;
+    double min;
+    double max;
+    double sum;
+    quint32 count;
+
+    double mean() const { return count ? sum / count : 0; }
+};
+
+class RollupTiers
+{
+public:
+    static const int RawTier = -1;
+
+    RollupTiers();
+
+    void append(qint64 timeNs, double value);
+    //value stayed put over (fromNs, toNs), as with report on change firmware. Gives every
+    //finest tier bucket in between one sample of it so the summaries don't show gaps.
+    void hold(qint64 fromNs, qint64 toNs, double value);
+    void clear();
+
+    int tierCount() const { return m_tiers.size(); }
+    qint64 tierWidthNs(int tier) const { return m_tiers.at(tier).widthNs; }
+
+    //Coarsest tier with at least one bucket per pixel over [fromNs, toNs], or RawTier
+    int pickTier(qint64 fromNs, qint64 toNs, int pixels) const;
+
+    //Buckets of tier overlapping [fromNs, toNs], replaces the contents of out
+    void buckets(int tier, qint64 fromNs, qint64 toNs, QVector<RollupBucket> &out) const;
+
+    //Oldest time a tier still has buckets for, older ranges must come from a coarser tier
+    qint64 tierStartNs(int tier) const;
+
+private:
+    struct Tier {
+        qint64 widthNs;
+        qint64 retentionNs;   //0 keeps everything
+        QVector<RollupBucket> buckets;
+    };
+
+    void trim(Tier &tier);
+
+    QVector<Tier> m_tiers;
+};
+
+#endif // ROLLUPTIERS_H
@@ -0,0 +1,121 @@
+#include "sampleclock.h"
+
+#include <QDateTime>
+
+#include <cmath>
+
+SampleClock::SampleClock()
+{
+    m_timer.start();
+    m_epochNs = QDateTime::currentMSecsSinceEpoch() * 1000000;
+}
+
+ClockReconciler::ClockReconciler(int window) :
+    m_window(qMax(8, window))
+{
+    m_points.resize(m_window);
+}
+
+void ClockReconciler::reset()
+{
+    m_next = 0;
+    m_count = 0;
+    m_sinceRebase = 0;
+    m_sx = m_sy = m_sxx = m_sxy = 0;
+    m_slope = 0;
+    m_intercept = 0;
+    m_jitter = 0;
+    m_referenceSlope = 0;
+}
+
+qint64 ClockReconciler::toHostNs(qint64 counter) const
+{
+    return m_originNs + qRound64(m_intercept + m_slope * double(counter - m_originCounter));
+}
+
+double ClockReconciler::driftPpm(double nominalNsPerCount) const
+{
+    if (!isValid() || nominalNsPerCount <= 0)
+        return 0;
+    return (m_slope / nominalNsPerCount - 1.0) * 1e6;
+}
+
+void ClockReconciler::observe(qint64 counter, qint64 hostNs)
+{
+    if (m_count > 0 && counter <= m_lastCounter)
+        reset();
+
+    if (isValid()) {
+        const double residual = double(hostNs - toHostNs(counter));
+        //Far off the line: the device restarted or the link was down, start a new fit
+        if (std::fabs(residual) > qMax(50.0 * m_jitter, 100.0 * m_slope)) {
+            reset();
+        } else {
+            m_jitter += (std::fabs(residual) - m_jitter) / 16.0;
+        }
+    }
+
+    if (m_count == 0) {
+        m_originCounter = counter;
+        m_originNs = hostNs;
+    }
+    m_lastCounter = counter;
+
+    const Point p = { double(counter - m_originCounter), double(hostNs - m_originNs) };
+    if (m_count == m_window) {
+        const Point &old = m_points[m_next];
+        m_sx -= old.x;
+        m_sy -= old.y;
+        m_sxx -= old.x * old.x;
+        m_sxy -= old.x * old.y;
+    } else {
+        m_count++;
+    }
+    m_points[m_next] = p;
+    m_next = (m_next + 1) % m_window;
+    m_sx += p.x;
+    m_sy += p.y;
+    m_sxx += p.x * p.x;
+    m_sxy += p.x * p.y;
+
+    //Running sums drift and the origin falls behind, redo them from the window now and then
+    if (++m_sinceRebase >= m_window)
+        rebase();
+    fit();
+    if (m_referenceSlope == 0 && m_count == m_window && m_slope > 0)
+        m_referenceSlope = m_slope;
+}
+
+void ClockReconciler::rebase()
+{
+    m_sinceRebase = 0;
+    const int oldest = m_count == m_window ? m_next : 0;
+    const Point first = m_points[oldest];
+    const qint64 dx = qint64(first.x);
+    const qint64 dy = qint64(first.y);
+    m_originCounter += dx;
+    m_originNs += dy;
+    m_sx = m_sy = m_sxx = m_sxy = 0;
+    for (int i = 0; i < m_count; i++) {
+        Point &p = m_points[i];
+        p.x -= dx;
+        p.y -= dy;
+        m_sx += p.x;
+        m_sy += p.y;
+        m_sxx += p.x * p.x;
+        m_sxy += p.x * p.y;
+    }
+}
+
+void ClockReconciler::fit()
+{
+    const double n = m_count;
+    const double denominator = n * m_sxx - m_sx * m_sx;
+    if (m_count < 2 || denominator <= 0) {
+        m_slope = 0;
+        m_intercept = m_count ? m_sy / n : 0;
+        return;
+    }
+    m_slope = (n * m_sxy - m_sx * m_sy) / denominator;
+    m_intercept = (m_sy - m_slope * m_sx) / n;
+}
@@ -0,0 +1,73 @@
+/*
+ * Purpose: Time stamping for samples.
+ * SampleClock reads a monotonic nanosecond clock and anchors it to the wall clock once at
+ * start up, so stamps are in ns since the epoch but never jump when NTP steps the system time.
+ * ClockReconciler fits host time against a device counter (sample number or device ticks)
+ * with a sliding-window least squares line. It gives the offset and rate (drift) mapping
+ * device time to host time, and a running estimate of the link jitter around that line.
+ * */
+
+#ifndef SAMPLECLOCK_H
+#define SAMPLECLOCK_H
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <QtGlobal>
+
+class SampleClock
+{
+public:
+    SampleClock();
+
+    qint64 nowNs() const { return m_epochNs + m_timer.nsecsElapsed(); }
+
+private:
+    QElapsedTimer m_timer;
+    qint64 m_epochNs;
+};
+
+class ClockReconciler
+{
+public:
+    explicit ClockReconciler(int window = 256);
+
+    //Feed one (device counter, host arrival time) pair. Counters must increase; a step back,
+    //or an arrival far off the current fit (device reset, long outage), restarts the fit.
+    void observe(qint64 counter, qint64 hostNs);
+    void reset();
+
+    //True once enough points have been seen to trust the fit
+    bool isValid() const { return m_count >= 8 && m_slope > 0; }
+    //Host time the device counter corresponds to
+    qint64 toHostNs(qint64 counter) const;
+    //Host ns per device count, the sample period when the counter is a sample number
+    double nsPerCount() const { return m_slope; }
+    //Mean absolute distance of arrivals from the fit, RFC 3550 style smoothing
+    double jitterNs() const { return m_jitter; }
+    //Device rate error in parts per million against a nominal ns per count
+    double driftPpm(double nominalNsPerCount) const;
+    //ns per count when the window first filled after a reset, 0 before that. The firmware
+    //free-runs, so this is the nominal driftPpm() is measured against.
+    double referenceNsPerCount() const { return m_referenceSlope; }
+
+private:
+    void fit();
+    void rebase();
+
+    struct Point { double x; double y; };
+    QVector<Point> m_points;    //ring buffer of the window, relative to the origin
+    int m_window;
+    int m_next = 0;
+    int m_count = 0;
+    int m_sinceRebase = 0;
+    qint64 m_originCounter = 0;
+    qint64 m_originNs = 0;
+    qint64 m_lastCounter = 0;
+    double m_sx = 0, m_sy = 0, m_sxx = 0, m_sxy = 0;
+    double m_slope = 0;
+    double m_intercept = 0;
+    double m_jitter = 0;
+    double m_referenceSlope = 0;
+};
+
+#endif // SAMPLECLOCK_H
@@ -0,0 +1,161 @@
+#include "samplefilters.h"
+
+#include <algorithm>
+#include <cmath>
+
+void RunningMedian::setWindow(int window)
+{
+    m_window = qMax(window, 0);
+    m_lower = QVector<Entry>();
+    m_upper = QVector<Entry>();
+    m_side = QVector<quint8>();
+    if (m_window) {
+        //Each heap is compacted before it passes twice the window, so this is all they ever need
+        m_lower.reserve(2 * m_window + 1);
+        m_upper.reserve(2 * m_window + 1);
+        m_side.fill(Lower, m_window);
+    }
+    reset();
+}
+
+void RunningMedian::reset()
+{
+    m_lower.resize(0);
+    m_upper.resize(0);
+    m_lowerCount = 0;
+    m_upperCount = 0;
+    m_sequence = 0;
+}
+
+void RunningMedian::prune(QVector<Entry> &heap, bool (*order)(const Entry &, const Entry &))
+{
+    while (!heap.isEmpty() && expired(heap.first())) {
+        std::pop_heap(heap.begin(), heap.end(), order);
+        heap.removeLast();
+    }
+}
+
+void RunningMedian::push(Side side, const Entry &entry)
+{
+    QVector<Entry> &heap = side == Lower ? m_lower : m_upper;
+    bool (*order)(const Entry &, const Entry &) = side == Lower ? below : above;
+    heap.append(entry);
+    std::push_heap(heap.begin(), heap.end(), order);
+    m_side[int(entry.sequence % m_window)] = side;
+    (side == Lower ? m_lowerCount : m_upperCount)++;
+    compact(heap, order);
+}
+
+void RunningMedian::move(Side from)
+{
+    QVector<Entry> &heap = from == Lower ? m_lower : m_upper;
+    const Entry entry = heap.first();
+    std::pop_heap(heap.begin(), heap.end(), from == Lower ? below : above);
+    heap.removeLast();
+    (from == Lower ? m_lowerCount : m_upperCount)--;
+    push(from == Lower ? Upper : Lower, entry);
+}
+
+void RunningMedian::compact(QVector<Entry> &heap, bool (*order)(const Entry &, const Entry &))
+{
+    //Expired readings buried under live ones never reach the top on their own
+    if (heap.size() <= 2 * m_window)
+        return;
+    heap.erase(std::remove_if(heap.begin(), heap.end(), [this](const Entry &e) { return expired(e); }),
+               heap.end());
+    std::make_heap(heap.begin(), heap.end(), order);
+}
+
+void RunningMedian::process(double *values, int count)
+{
+    if (m_window == 0)
+        return;
+    for (int i = 0; i < count; i++) {
+        //NaN has no place in the order, let it through untouched
+        if (std::isnan(values[i]))
+            continue;
+        m_sequence++;
+        //The reading leaving the window used the slot the new one takes
+        if (m_sequence > m_window)
+            (m_side[int(m_sequence % m_window)] == Lower ? m_lowerCount : m_upperCount)--;
+
+        const Entry entry = {values[i], m_sequence};
+        prune(m_lower, below);
+        push(!m_lower.isEmpty() && !below(m_lower.first(), entry) ? Lower : Upper, entry);
+
+        //Keep (n + 1) / 2 readings in the lower heap, one move always restores it
+        if (m_lowerCount > m_upperCount + 1) {
+            prune(m_lower, below);
+            move(Lower);
+        } else if (m_lowerCount < m_upperCount) {
+            prune(m_upper, above);
+            move(Upper);
+        }
+        prune(m_lower, below);
+        //Lower median while the window is still filling with an even count
+        values[i] = m_lower.first().value;
+    }
+}
+
+void LowPassFilter::process(const qint64 *timeNs, double *values, int count)
+{
+    if (m_tauNs <= 0)
+        return;
+    for (int i = 0; i < count; i++) {
+        if (!m_primed) {
+            m_primed = true;
+            m_state = values[i];
+        } else {
+            const double dt = double(qMax(timeNs[i] - m_lastNs, qint64(0)));
+            m_state += (1 - std::exp(-dt / m_tauNs)) * (values[i] - m_state);
+        }
+        m_lastNs = timeNs[i];
+        values[i] = m_state;
+    }
+}
+
+void KalmanFilter::process(const qint64 *timeNs, double *values, int count)
+{
+    if (m_drift <= 0)
+        return;
+    const double r = MeasurementSigma * MeasurementSigma;
+    const double q = m_drift * m_drift;
+    for (int i = 0; i < count; i++) {
+        if (!m_primed) {
+            m_primed = true;
+            m_estimate = values[i];
+            m_variance = r;
+        } else {
+            //Predict: the temperature may have wandered since the last reading
+            m_variance += q * double(qMax(timeNs[i] - m_lastNs, qint64(0))) / 1e9;
+            //Update
+            const double gain = m_variance / (m_variance + r);
+            m_estimate += gain * (values[i] - m_estimate);
+            m_variance *= 1 - gain;
+        }
+        m_lastNs = timeNs[i];
+        values[i] = m_estimate;
+    }
+}
+
+void FilterChain::configure(int medianWindow, double lowPassSeconds, double kalmanDrift)
+{
+    m_median.setWindow(medianWindow);
+    m_lowPass.setTimeConstant(lowPassSeconds);
+    m_kalman.setDrift(kalmanDrift);
+}
+
+void FilterChain::reset()
+{
+    m_median.reset();
+    m_lowPass.reset();
+    m_kalman.reset();
+}
+
+void FilterChain::process(const qint64 *timeNs, double *values, int count)
+{
+    //Median first so a glitch never reaches the smoothing stages
+    m_median.process(values, count);
+    m_lowPass.process(timeNs, values, count);
+    m_kalman.process(timeNs, values, count);
+}
@@ -0,0 +1,115 @@
+/*
+ * Purpose: Streaming filters applied to readings between decoding and storage, to take out
+ * single sample glitches and quantisation noise before an operator sees them:
+ *
+ *   RunningMedian   median of the last w readings in O(log w) per sample, at full resolution.
+ *                   The lower half is kept in a max-heap and the upper half in a min-heap, a
+ *                   reading that leaves the window is only dropped once it reaches a top.
+ *   LowPassFilter   first order IIR with a time constant in seconds, the coefficient comes from
+ *                   each sample's own spacing so report on change gaps are handled.
+ *   KalmanFilter    1-D random walk model. The drift setting is how fast the real temperature
+ *                   may wander (C per square root second) against the sensor's 1 LSB noise.
+ *
+ * FilterChain runs whichever are enabled, in that order, over a whole batch in place. Memory is
+ * only allocated by configure(), never per sample.
+ * */
+
+#ifndef SAMPLEFILTERS_H
+#define SAMPLEFILTERS_H
+
+#include <QVector>
+#include <QtGlobal>
+
+class RunningMedian
+{
+public:
+    //window 0 disables the filter and frees its heaps
+    void setWindow(int window);
+    int window() const { return m_window; }
+    void reset();
+    void process(double *values, int count);
+
+private:
+    struct Entry
+    {
+        double value;
+        qint64 sequence;    //Arrival number, also breaks ties so the order is total
+    };
+    enum Side : quint8 { Lower, Upper };
+
+    static bool below(const Entry &a, const Entry &b)
+    {
+        return a.value < b.value || (a.value == b.value && a.sequence < b.sequence);
+    }
+    static bool above(const Entry &a, const Entry &b) { return below(b, a); }
+
+    bool expired(const Entry &entry) const { return entry.sequence <= m_sequence - m_window; }
+    //Pops readings that have left the window off the top of a heap
+    void prune(QVector<Entry> &heap, bool (*order)(const Entry &, const Entry &));
+    void push(Side side, const Entry &entry);
+    //Moves the top of one heap to the other, it must already be pruned
+    void move(Side from);
+    //Drops every expired reading once a heap has grown to twice the window
+    void compact(QVector<Entry> &heap, bool (*order)(const Entry &, const Entry &));
+
+    int m_window = 0;
+    QVector<Entry> m_lower;     //Max-heap, holds the median at its top
+    QVector<Entry> m_upper;     //Min-heap
+    QVector<quint8> m_side;     //Heap each reading in the window is in, by sequence % window
+    int m_lowerCount = 0;       //Readings in the window, not counting expired ones
+    int m_upperCount = 0;
+    qint64 m_sequence = 0;      //Arrival number of the newest reading
+};
+
+class LowPassFilter
+{
+public:
+    void setTimeConstant(double seconds) { m_tauNs = seconds * 1e9; reset(); }
+    bool isEnabled() const { return m_tauNs > 0; }
+    void reset() { m_primed = false; }
+    void process(const qint64 *timeNs, double *values, int count);
+
+private:
+    double m_tauNs = 0;
+    bool m_primed = false;
+    double m_state = 0;
+    qint64 m_lastNs = 0;
+};
+
+class KalmanFilter
+{
+public:
+    //One LSB of the ADT7420 in 13 bit mode
+    static constexpr double MeasurementSigma = 0.0625;
+
+    void setDrift(double celsiusPerRootSecond) { m_drift = celsiusPerRootSecond; reset(); }
+    bool isEnabled() const { return m_drift > 0; }
+    void reset() { m_primed = false; }
+    void process(const qint64 *timeNs, double *values, int count);
+
+private:
+    double m_drift = 0;
+    bool m_primed = false;
+    double m_estimate = 0;
+    double m_variance = 0;
+    qint64 m_lastNs = 0;
+};
+
+class FilterChain
+{
+public:
+    //Zero turns a stage off
+    void configure(int medianWindow, double lowPassSeconds, double kalmanDrift);
+    bool isEmpty() const { return !m_median.window() && !m_lowPass.isEnabled() && !m_kalman.isEnabled(); }
+    void reset();
+
+    //Filters count readings taken at timeNs, in place
+    void process(const qint64 *timeNs, double *values, int count);
+
+private:
+    RunningMedian m_median;
+    LowPassFilter m_lowPass;
+    KalmanFilter m_kalman;
+};
+
+#endif // SAMPLEFILTERS_H
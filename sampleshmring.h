@@ -0,0 +1,172 @@
+/*
+ * Purpose: Layout of the shared-memory ring the monitor publishes decoded samples into,
+ * plus the inline reader (and single writer) functions.
+ *
+ * This header is plain C99/C++ with no Qt so local control software can include it on its own.
+ * Map the segment with shm_open(SSR_DEFAULT_NAME, O_RDONLY, 0) + mmap(PROT_READ, MAP_SHARED)
+ * and call ssr_read_latest() / ssr_read_next(). Readers never take a lock or make a syscall,
+ * and the writer never waits for readers.
+ *
+ * Every slot carries a seqlock: the writer makes seq odd, fills the slot, then makes it even.
+ * A reader copies the slot between two seq loads and retries if they differ or are odd.
+ * Slots also hold the sample index so a reader that fell a whole ring behind can tell it was lapped.
+ * */
+
+#ifndef SAMPLESHMRING_H
+#define SAMPLESHMRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#define SSR_DEFAULT_NAME     "/temp_sensor_samples"
+#define SSR_MAGIC            0x52525354u /* "TSRR" */
+#define SSR_VERSION          1u
+#define SSR_DEFAULT_CAPACITY 4096u /* must be a power of two */
+
+typedef struct {
+    uint32_t seq;           /* odd while the writer is filling the slot */
+    uint32_t sensor_id;
+    uint64_t index;         /* 0-based number of this sample since the ring was created */
+    int64_t  timestamp_ns;  /* sample time, ns since the Unix epoch */
+    int64_t  publish_ns;    /* CLOCK_MONOTONIC when the slot was written, for latency measurement */
+    double   celsius;
+    uint32_t raw;           /* undecoded sensor code */
+    uint32_t reserved;
+    uint8_t  pad[16];       /* one slot per 64 byte cache line */
+} ssr_slot;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t slot_size;
+    uint8_t  pad0[48];
+    uint64_t head;          /* number of samples published, written last by the writer */
+    uint8_t  pad1[56];
+} ssr_header;
+
+typedef struct {
+    ssr_header header;
+    ssr_slot slots[1];      /* header.capacity slots */
+} ssr_ring;
+
+typedef char ssr_slot_is_one_cache_line[sizeof(ssr_slot) == 64 ? 1 : -1];
+typedef char ssr_header_is_two_cache_lines[sizeof(ssr_header) == 128 ? 1 : -1];
+
+static inline size_t ssr_ring_bytes(uint32_t capacity)
+{
+    return sizeof(ssr_header) + (size_t)capacity * sizeof(ssr_slot);
+}
+
+static inline int64_t ssr_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Returns 1 if the mapped memory holds a ring this header understands */
+static inline int ssr_is_valid(const ssr_ring *ring)
+{
+    return ring->header.magic == SSR_MAGIC
+            && ring->header.version == SSR_VERSION
+            && ring->header.slot_size == sizeof(ssr_slot)
+            && ring->header.capacity != 0
+            && (ring->header.capacity & (ring->header.capacity - 1)) == 0;
+}
+
+static inline uint64_t ssr_head(const ssr_ring *ring)
+{
+    return __atomic_load_n(&ring->header.head, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Copies the slot holding sample 'index' into *out.
+ * Returns 1 on success, 0 if that sample has been overwritten (the reader was lapped).
+ */
+static inline int ssr_read_index(const ssr_ring *ring, uint64_t index, ssr_slot *out)
+{
+    const ssr_slot *slot = &ring->slots[index & (ring->header.capacity - 1)];
+    uint32_t before, after;
+    do {
+        before = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        while (before & 1u)
+            before = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        memcpy(out, slot, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    } while (before != after);
+    return out->index == index;
+}
+
+/* Copies the most recent sample into *out. Returns 0 if nothing was published yet. */
+static inline int ssr_read_latest(const ssr_ring *ring, ssr_slot *out)
+{
+    for (;;) {
+        const uint64_t head = ssr_head(ring);
+        if (head == 0)
+            return 0;
+        if (ssr_read_index(ring, head - 1, out))
+            return 1;
+    }
+}
+
+/*
+ * Reads the next sample after *cursor (start with *cursor = 0, or ssr_head() to skip history).
+ * Returns 1 and advances *cursor when a sample was copied, 0 when the reader is caught up.
+ * A reader more than a ring behind jumps to the oldest sample still present; the number of
+ * samples skipped is added to *lost when lost is not NULL.
+ */
+static inline int ssr_read_next(const ssr_ring *ring, uint64_t *cursor, ssr_slot *out, uint64_t *lost)
+{
+    for (;;) {
+        const uint64_t head = ssr_head(ring);
+        if (*cursor >= head)
+            return 0;
+        if (head - *cursor > ring->header.capacity) {
+            const uint64_t oldest = head - ring->header.capacity;
+            if (lost)
+                *lost += oldest - *cursor;
+            *cursor = oldest;
+        }
+        if (ssr_read_index(ring, *cursor, out)) {
+            ++*cursor;
+            return 1;
+        }
+        /* Overwritten while we looked, go round again with a fresh head */
+    }
+}
+
+/* Writer side, only the monitor calls these. There must be exactly one writer. */
+static inline void ssr_init(ssr_ring *ring, uint32_t capacity)
+{
+    memset(ring, 0, ssr_ring_bytes(capacity));
+    ring->header.capacity = capacity;
+    ring->header.slot_size = sizeof(ssr_slot);
+    ring->header.version = SSR_VERSION;
+    __atomic_store_n(&ring->header.magic, SSR_MAGIC, __ATOMIC_RELEASE);
+}
+
+static inline void ssr_publish(ssr_ring *ring, uint32_t sensor_id, int64_t timestamp_ns,
+                               double celsius, uint32_t raw)
+{
+    const uint64_t index = __atomic_load_n(&ring->header.head, __ATOMIC_RELAXED);
+    ssr_slot *slot = &ring->slots[index & (ring->header.capacity - 1)];
+    const uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->sensor_id = sensor_id;
+    slot->index = index;
+    slot->timestamp_ns = timestamp_ns;
+    slot->publish_ns = ssr_monotonic_ns();
+    slot->celsius = celsius;
+    slot->raw = raw;
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&ring->header.head, index + 1, __ATOMIC_RELEASE);
+}
+
+#endif // SAMPLESHMRING_H
@@ -0,0 +1,73 @@
+#include "sessionjournal.h"
+
+static const quint32 JournalMagic = 0x4A534754; //"TGSJ" read as little endian
+static const quint32 JournalVersion = 1;
+
+SessionJournal::~SessionJournal()
+{
+    close();
+}
+
+bool SessionJournal::open(const QString &fileName, quint32 capacity)
+{
+    if (isOpen())
+        return true;
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        m_errorString = QStringLiteral("Journal capacity must be a power of two");
+        return false;
+    }
+
+    //Two instances appending to one ring would interleave their records
+    m_lock.reset(new QLockFile(fileName + QStringLiteral(".lock")));
+    m_lock->setStaleLockTime(0);
+    if (!m_lock->tryLock(0)) {
+        m_errorString = QStringLiteral("The journal is in use by another instance");
+        m_lock.reset();
+        return false;
+    }
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        m_errorString = m_file.errorString();
+        close();
+        return false;
+    }
+    const qint64 bytes = qint64(sizeof(Header)) + qint64(capacity) * qint64(sizeof(Record));
+    const bool fresh = m_file.size() != bytes;
+    if (fresh && !m_file.resize(bytes)) {
+        m_errorString = m_file.errorString();
+        close();
+        return false;
+    }
+    uchar *mem = m_file.map(0, bytes);
+    if (!mem) {
+        m_errorString = m_file.errorString();
+        close();
+        return false;
+    }
+
+    m_header = reinterpret_cast<Header *>(mem);
+    m_records = reinterpret_cast<Record *>(mem + sizeof(Header));
+    if (fresh || m_header->magic != JournalMagic || m_header->version != JournalVersion
+            || m_header->recordSize != sizeof(Record) || m_header->capacity != capacity) {
+        //Anything else (an older layout, another capacity) starts over rather than being converted
+        *m_header = Header();
+        m_header->magic = JournalMagic;
+        m_header->version = JournalVersion;
+        m_header->recordSize = sizeof(Record);
+        m_header->capacity = capacity;
+    }
+    return true;
+}
+
+void SessionJournal::close()
+{
+    if (m_header)
+        m_file.unmap(reinterpret_cast<uchar *>(m_header));
+    m_header = nullptr;
+    m_records = nullptr;
+    for (qint64 &nextNs : m_nextNs)
+        nextNs = 0;
+    m_file.close();
+    m_lock.reset();
+}
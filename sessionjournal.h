@@ -0,0 +1,127 @@
+/*
+ * Purpose: Rolling on-disk journal of the most recent samples, so a restart (upgrade, crash)
+ * can put the recent trend back on screen before the port is even connected.
+ *
+ * The journal is a fixed size ring of fixed size records in a memory mapped file. Appending is
+ * a 24 byte store and a counter bump, the kernel writes the dirty pages back on its own, so the
+ * GUI thread never waits on the disk. A crash of the app loses nothing already appended; a power
+ * cut loses whatever the kernel had not written back yet.
+ *
+ * Only the first reading of each sensor in every IntervalNs is kept, so how far back the ring
+ * reaches depends on the sensor count and not on the rate the board sends at (thousands of
+ * readings a second would fill it in minutes).
+ *
+ *   header   "TGSJ" magic (u32), version (u32), record size (u32), capacity (u32, a power of two),
+ *            records ever appended (u64)
+ *   records  capacity slots, record n lives in slot n % capacity
+ *
+ * Records are appended in time order, so restore() finds the start of the window it wants with
+ * a binary search and only touches the pages it replays.
+ * */
+
+#ifndef SESSIONJOURNAL_H
+#define SESSIONJOURNAL_H
+
+#include <QFile>
+#include <QLockFile>
+#include <QScopedPointer>
+#include <QString>
+#include <QtGlobal>
+
+#include "taggedframe.h"
+
+class SessionJournal
+{
+public:
+    struct Record {
+        qint64 timeNs;
+        double celsius;
+        quint32 raw;
+        qint32 sensor;      //-1 for the single sensor formats
+    };
+
+    SessionJournal() = default;
+    ~SessionJournal();
+
+    //Maps fileName, creating or resetting it if it isn't a journal of this capacity. Fails when
+    //another instance of the app holds the journal.
+    bool open(const QString &fileName, quint32 capacity = DefaultCapacity);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+    QString errorString() const { return m_errorString; }
+
+    //A no-op when the journal could not be opened, or when the sensor already has a record
+    //less than IntervalNs old
+    void append(qint64 timeNs, quint32 raw, double celsius, int sensor)
+    {
+        if (!m_header)
+            return;
+        qint64 &nextNs = m_nextNs[qBound(0, sensor + 1, Tracks - 1)];
+        if (timeNs < nextNs)
+            return;
+        nextNs = timeNs + IntervalNs;
+        Record &r = m_records[m_header->count & (m_header->capacity - 1)];
+        r.timeNs = timeNs;
+        r.celsius = celsius;
+        r.raw = raw;
+        r.sensor = sensor;
+        m_header->count++;
+    }
+
+    //Calls sink(const Record &) for every journalled record at or after fromNs, oldest first.
+    //Returns how many there were.
+    template <typename Sink>
+    quint64 restore(qint64 fromNs, Sink sink) const;
+
+    //Ten records a second per sensor is plenty for a trend on a chart
+    static const qint64 IntervalNs = 100000000;
+    //24 MiB. At one record per sensor per IntervalNs that is 7.3 hours with all four sensors of
+    //the tagged format and 29 hours with one, whatever the board's reading rate.
+    static const quint32 DefaultCapacity = 1u << 20;
+
+private:
+    Q_DISABLE_COPY(SessionJournal)
+
+    struct Header {
+        quint32 magic;
+        quint32 version;
+        quint32 recordSize;
+        quint32 capacity;
+        quint64 count;
+        quint64 reserved[5];
+    };
+
+    //Single sensor formats, then each tagged sensor
+    static const int Tracks = TaggedFrame::MaxSensors + 1;
+
+    const Record &at(quint64 n) const { return m_records[n & (m_header->capacity - 1)]; }
+
+    QFile m_file;
+    QScopedPointer<QLockFile> m_lock;
+    Header *m_header = nullptr;
+    Record *m_records = nullptr;
+    qint64 m_nextNs[Tracks] = {};   //Earliest time each sensor's next record may have
+    QString m_errorString;
+};
+
+template <typename Sink>
+quint64 SessionJournal::restore(qint64 fromNs, Sink sink) const
+{
+    if (!m_header)
+        return 0;
+    const quint64 end = m_header->count;
+    quint64 first = end > m_header->capacity ? end - m_header->capacity : 0;
+    quint64 last = end;
+    while (first < last) {
+        const quint64 mid = first + (last - first) / 2;
+        if (at(mid).timeNs < fromNs)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    for (quint64 n = first; n < end; n++)
+        sink(at(n));
+    return end - first;
+}
+
+#endif // SESSIONJOURNAL_H
@@ -51,12 +51,16 @@
 
 #include "settingsdialog.h"
 #include "ui_settingsdialog.h"
+#include "nativeserialport.h"
+#include "framecodec.h"
 
 #include <QIntValidator>
 #include <QLineEdit>
 #include <QSerialPortInfo>
 
 static const char blankString[] = QT_TRANSLATE_NOOP("SettingsDialog", "N/A");
+//Wire format items keep the WireFormat in Qt::UserRole and the codec index here
+static const int CodecRole = Qt::UserRole + 1;
 
 SettingsDialog::SettingsDialog(QWidget *parent) :
     QDialog(parent),
@@ -168,6 +172,20 @@ void SettingsDialog::fillPortsParameters()
     m_ui->flowControlBox->addItem(tr("None"), QSerialPort::NoFlowControl);
     m_ui->flowControlBox->addItem(tr("RTS/CTS"), QSerialPort::HardwareControl);
     m_ui->flowControlBox->addItem(tr("XON/XOFF"), QSerialPort::SoftwareControl);
+
+    //One entry per registered codec, then the framed formats of our own firmware
+    for (int i = 0; i < FrameCodecRegistry::count(); i++) {
+        m_ui->wireFormatBox->addItem(FrameCodecRegistry::name(i), WordWire);
+        m_ui->wireFormatBox->setItemData(m_ui->wireFormatBox->count() - 1, i, CodecRole);
+    }
+    m_ui->wireFormatBox->addItem(tr("Delta frames"), DeltaWire);
+    m_ui->wireFormatBox->addItem(tr("Tagged frames, all sensors"), TaggedWire);
+
+    m_ui->readerBox->addItem(tr("QSerialPort"), QtSerialPortReader);
+    if (NativeSerialPort::isAvailable()) {
+        m_ui->readerBox->addItem(tr("Native"), NativeReader);
+        m_ui->readerBox->addItem(tr("Native, low latency"), NativeLowLatencyReader);
+    }
 }
 
 void SettingsDialog::fillPortsInfo()
@@ -225,4 +243,19 @@ void SettingsDialog::updateSettings()
     m_currentSettings.stringFlowControl = m_ui->flowControlBox->currentText();
 
     m_currentSettings.localEchoEnabled = m_ui->localEchoCheckBox->isChecked();
+    m_currentSettings.reportOnChange = m_ui->reportOnChangeCheckBox->isChecked();
+    m_currentSettings.heartbeatMs = m_ui->heartbeatBox->value();
+
+    m_currentSettings.wireFormat = static_cast<WireFormat>(
+                m_ui->wireFormatBox->itemData(m_ui->wireFormatBox->currentIndex()).toInt());
+    m_currentSettings.codec = m_ui->wireFormatBox->itemData(m_ui->wireFormatBox->currentIndex(), CodecRole).toInt();
+    m_currentSettings.stringWireFormat = m_ui->wireFormatBox->currentText();
+
+    m_currentSettings.reader = static_cast<SerialReader>(
+                m_ui->readerBox->itemData(m_ui->readerBox->currentIndex()).toInt());
+    m_currentSettings.stringReader = m_ui->readerBox->currentText();
+
+    m_currentSettings.medianWindow = m_ui->medianWindowBox->value();
+    m_currentSettings.lowPassSeconds = m_ui->lowPassBox->value();
+    m_currentSettings.kalmanDrift = m_ui->kalmanBox->value();
 }
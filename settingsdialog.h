@@ -70,6 +70,19 @@ class SettingsDialog : public QDialog
     Q_OBJECT
 
 public:
+    enum SerialReader {
+        QtSerialPortReader,
+        NativeReader,           //epoll on the tty, see nativeserialport.h
+        NativeLowLatencyReader  //NativeReader plus ASYNC_LOW_LATENCY and a time critical thread
+    };
+
+    enum WireFormat {
+        WordWire,               //One fixed size reading per frame, decoded by the codec picked from
+                                //FrameCodecRegistry (framecodec.h). WIRE_RAW16 in main.c for the ADT7420
+        DeltaWire,              //Delta frames, WIRE_DELTA in main.c, see deltaframe.h
+        TaggedWire              //Every sensor on the bus, WIRE_TAGGED in main.c, see taggedframe.h
+    };
+
     struct Settings {
         QString name;
         qint32 baudRate;
@@ -83,6 +96,16 @@ public:
         QSerialPort::FlowControl flowControl;
         QString stringFlowControl;
         bool localEchoEnabled;
+        bool reportOnChange;    //Firmware only sends readings that moved, hold values in between
+        int heartbeatMs;        //Longest gap the firmware leaves between sends in that mode
+        WireFormat wireFormat;
+        int codec;              //FrameCodecRegistry index, for WordWire
+        QString stringWireFormat;
+        SerialReader reader;
+        QString stringReader;
+        int medianWindow;       //Filter settings, 0 turns a stage off, see samplefilters.h
+        double lowPassSeconds;
+        double kalmanDrift;
     };
 
     explicit SettingsDialog(QWidget *parent = nullptr);
@@ -0,0 +1,91 @@
+#include "sharedmemorypublisher.h"
+
+#include <QDir>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+SharedMemoryPublisher::SharedMemoryPublisher(const QString &name, quint32 capacity) :
+    m_name(name), m_capacity(capacity)
+{
+}
+
+SharedMemoryPublisher::~SharedMemoryPublisher()
+{
+    close();
+}
+
+bool SharedMemoryPublisher::open()
+{
+    if (m_ring)
+        return true;
+    if (m_capacity == 0 || (m_capacity & (m_capacity - 1)) != 0) {
+        m_errorString = QStringLiteral("Ring capacity must be a power of two");
+        return false;
+    }
+
+#ifdef Q_OS_UNIX
+    const QByteArray name = m_name.toLocal8Bit();
+    const size_t bytes = ssr_ring_bytes(m_capacity);
+
+    //Only one monitor may own the name. The lock goes away with a crashed owner, whose
+    //leftover segment is then safe to replace.
+    QString lockName = m_name;
+    lockName.replace(QLatin1Char('/'), QLatin1Char('_'));
+    m_lock.reset(new QLockFile(QDir::temp().filePath(lockName + QStringLiteral(".lock"))));
+    m_lock->setStaleLockTime(0);
+    if (!m_lock->tryLock(0)) {
+        m_errorString = QStringLiteral("Another monitor is already publishing to %1").arg(m_name);
+        m_lock.reset();
+        return false;
+    }
+
+    //Start from a fresh segment, readers still holding the old mapping keep the old ring
+    shm_unlink(name.constData());
+    const int fd = shm_open(name.constData(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        m_lock.reset();
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        ::close(fd);
+        shm_unlink(name.constData());
+        m_lock.reset();
+        return false;
+    }
+    void *mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        shm_unlink(name.constData());
+        m_lock.reset();
+        return false;
+    }
+
+    m_ring = static_cast<ssr_ring *>(mem);
+    ssr_init(m_ring, m_capacity);
+    return true;
+#else
+    m_errorString = QStringLiteral("Shared memory publishing needs a POSIX system");
+    return false;
+#endif
+}
+
+void SharedMemoryPublisher::close()
+{
+#ifdef Q_OS_UNIX
+    if (!m_ring)
+        return;
+    munmap(m_ring, ssr_ring_bytes(m_capacity));
+    shm_unlink(m_name.toLocal8Bit().constData());
+    m_ring = nullptr;
+    m_lock.reset();
+#endif
+}
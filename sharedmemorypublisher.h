@@ -0,0 +1,47 @@
+/*
+ * Purpose: Owns the POSIX shared-memory segment that decoded samples are published into,
+ * so other processes on the same machine can read them without going through a socket.
+ * The layout and the reader functions live in sampleshmring.h
+ * */
+
+#ifndef SHAREDMEMORYPUBLISHER_H
+#define SHAREDMEMORYPUBLISHER_H
+
+#include <QLockFile>
+#include <QScopedPointer>
+#include <QString>
+#include <QtGlobal>
+
+#include "sampleshmring.h"
+
+class SharedMemoryPublisher
+{
+public:
+    explicit SharedMemoryPublisher(const QString &name = QStringLiteral(SSR_DEFAULT_NAME),
+                                   quint32 capacity = SSR_DEFAULT_CAPACITY);
+    ~SharedMemoryPublisher();
+
+    //Fails when another monitor is already publishing under the same name
+    bool open();
+    void close();
+    bool isOpen() const { return m_ring != nullptr; }
+    QString errorString() const { return m_errorString; }
+
+    //Never blocks, a no-op when the segment could not be created
+    void publish(quint32 sensorId, qint64 timestampNs, double celsius, quint32 raw)
+    {
+        if (m_ring)
+            ssr_publish(m_ring, sensorId, timestampNs, celsius, raw);
+    }
+
+private:
+    Q_DISABLE_COPY(SharedMemoryPublisher)
+
+    QString m_name;
+    quint32 m_capacity;
+    ssr_ring *m_ring = nullptr;
+    QScopedPointer<QLockFile> m_lock;  //Held for as long as the segment is ours
+    QString m_errorString;
+};
+
+#endif // SHAREDMEMORYPUBLISHER_H
@@ -0,0 +1,27 @@
+#include "taggedframe.h"
+
+void TaggedFrameDecoder::reset()
+{
+    m_pending.resize(0);
+    m_badFrames = 0;
+    m_skippedBytes = 0;
+}
+
+bool TaggedFrameDecoder::decodeFrame(const uchar *data, int count)
+{
+    const int length = TaggedFrame::frameBytes(count);
+    uchar sum = 0;
+    for (int i = 1; i < length - 1; i++)
+        sum = uchar(sum + data[i]);
+    if (sum != data[length - 1])
+        return false;
+
+    const uchar *sample = data + TaggedFrame::HeaderBytes;
+    for (int k = 0; k < count; k++, sample += TaggedFrame::SampleBytes) {
+        if (sample[0] >= TaggedFrame::MaxSensors)
+            return false;
+        m_sensors[k] = sample[0];
+        m_readings[k] = quint16((sample[1] << 8) | sample[2]);
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+/*
+ * Purpose: Decoder for the firmware's tagged frame wire format (WIRE_TAGGED in main.c), which
+ * batches readings from every ADT7420 on the board's I2C bus into one stream:
+ *
+ *   0xA6 sync
+ *   count, 1 to 32 readings
+ *   counter of the first reading (u16, big endian), readings are numbered by the board
+ *   count times: sensor number (I2C address - 0x48), reading (u16, big endian)
+ *   checksum, the sum of every byte after the sync byte, mod 256
+ *
+ * Like DeltaFrameDecoder, feed() parses in place and only copies a frame split across reads.
+ * */
+
+#ifndef TAGGEDFRAME_H
+#define TAGGEDFRAME_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+namespace TaggedFrame {
+static const uchar Sync = 0xA6;
+static const int HeaderBytes = 4;
+static const int SampleBytes = 3;
+static const int MaxReadings = 32;
+static const int MaxSensors = 4;
+static const int MaxFrameBytes = HeaderBytes + MaxReadings * SampleBytes + 1;
+
+inline int frameBytes(int count) { return HeaderBytes + count * SampleBytes + 1; }
+}
+
+class TaggedFrameDecoder
+{
+public:
+    void reset();
+
+    //Calls sink(quint16 counter, const quint8 *sensors, const quint16 *readings, int count) for
+    //every good frame in data, and keeps a trailing partial frame for the next call
+    template <typename Sink>
+    void feed(const uchar *data, int size, Sink sink);
+
+    //Frames that failed the checksum and bytes skipped looking for a sync byte
+    quint64 badFrames() const { return m_badFrames; }
+    quint64 skippedBytes() const { return m_skippedBytes; }
+
+private:
+    template <typename Sink>
+    int parse(const uchar *data, int size, Sink &sink);
+    //Checks and unpacks the frame at data, false on a bad checksum or sensor number
+    bool decodeFrame(const uchar *data, int count);
+
+    QByteArray m_pending;
+    quint8 m_sensors[TaggedFrame::MaxReadings];
+    quint16 m_readings[TaggedFrame::MaxReadings];
+    quint64 m_badFrames = 0;
+    quint64 m_skippedBytes = 0;
+};
+
+template <typename Sink>
+int TaggedFrameDecoder::parse(const uchar *data, int size, Sink &sink)
+{
+    int i = 0;
+    while (i < size) {
+        if (data[i] != TaggedFrame::Sync) {
+            m_skippedBytes++;
+            i++;
+            continue;
+        }
+        if (size - i < 2)
+            break;
+        const int count = data[i + 1];
+        if (count < 1 || count > TaggedFrame::MaxReadings) {
+            //Not a count the board sends, so this was not a sync byte
+            m_skippedBytes++;
+            i++;
+            continue;
+        }
+        const int length = TaggedFrame::frameBytes(count);
+        if (size - i < length)
+            break;
+        if (!decodeFrame(data + i, count)) {
+            m_badFrames++;
+            i++;
+            continue;
+        }
+        sink(quint16((data[i + 2] << 8) | data[i + 3]), m_sensors, m_readings, count);
+        i += length;
+    }
+    return i;
+}
+
+template <typename Sink>
+void TaggedFrameDecoder::feed(const uchar *data, int size, Sink sink)
+{
+    if (!m_pending.isEmpty()) {
+        //Same as DeltaFrameDecoder::feed(), finish the leftover frame then parse in place again
+        const int old = m_pending.size();
+        const int take = qMin(size, TaggedFrame::MaxFrameBytes);
+        m_pending.append(reinterpret_cast<const char *>(data), take);
+        int used = parse(reinterpret_cast<const uchar *>(m_pending.constData()), m_pending.size(), sink);
+        if (used < old && take < size) {
+            m_pending.append(reinterpret_cast<const char *>(data) + take, size - take);
+            used += parse(reinterpret_cast<const uchar *>(m_pending.constData()) + used,
+                          m_pending.size() - used, sink);
+            m_pending.remove(0, used);
+            return;
+        }
+        if (used < old || take == size) {
+            m_pending.remove(0, used);
+            return;
+        }
+        m_pending.resize(0);
+        data += used - old;
+        size -= used - old;
+    }
+    const int used = parse(data, size, sink);
+    m_pending.append(reinterpret_cast<const char *>(data) + used, size - used);
+}
+
+#endif // TAGGEDFRAME_H
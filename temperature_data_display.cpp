@@ -1,9 +1,11 @@
 #include "temperature_data_display.h"
 #include "ui_temperature_data_display.h"
+#include "historyexporter.h"
 
 Temperature_Data_Display::Temperature_Data_Display(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::Temperature_Data_Display), port_Settings(new SettingsDialog), port(new QSerialPort), chart(new QChart)
+    ui(new Ui::Temperature_Data_Display), port_Settings(new SettingsDialog), port(new QSerialPort),
+    native_Port(new NativeSerialPort(sample_Clock, this)), chart(new QChart), refresh_Timer(new QTimer(this))
 {
     ui->setupUi(this);
 
@@ -11,9 +13,22 @@ Temperature_Data_Display::Temperature_Data_Display(QWidget *parent) :
     connect(ui->actionDisconnect, SIGNAL(triggered()), this, SLOT(closeSerialPort()));
     connect(ui->actionPort_Settings, &QAction::triggered, port_Settings, &SettingsDialog::show);
     connect(port, &QSerialPort::readyRead, this, &Temperature_Data_Display::grabData);
+    connect(native_Port, &NativeSerialPort::dataReceived, this, &Temperature_Data_Display::processBytes);
+    connect(native_Port, &NativeSerialPort::errorOccurred, this, &Temperature_Data_Display::readerError);
+    connect(ui->actionSave_History, &QAction::triggered, this, &Temperature_Data_Display::saveHistory);
+    connect(ui->actionLoad_History, &QAction::triggered, this, &Temperature_Data_Display::loadHistory);
+    connect(ui->actionExport_History, &QAction::triggered, this, &Temperature_Data_Display::exportHistory);
+    connect(ui->actionAnalyze_Capture, &QAction::triggered, this, &Temperature_Data_Display::analyzeCapture);
+    connect(ui->actionFollow_Live, &QAction::triggered, this, &Temperature_Data_Display::followLive);
+    connect(ui->actionShow_Raw, &QAction::toggled, this, &Temperature_Data_Display::updateSeriesVisibility);
+    connect(ui->actionShow_Filtered, &QAction::toggled, this, &Temperature_Data_Display::updateSeriesVisibility);
+    connect(ui->actionAutoscale_Y, &QAction::toggled, this, &Temperature_Data_Display::setAutoscale);
+    connect(ui->actionLive_Span, &QAction::triggered, this, &Temperature_Data_Display::chooseLiveSpan);
+    connect(ui->actionAutoscale_Padding, &QAction::triggered, this, &Temperature_Data_Display::chooseAutoscalePadding);
+    connect(ui->graphView, &HistoryChartView::rangeRequested, this, &Temperature_Data_Display::setViewRange);
+    connect(ui->graphView, &HistoryChartView::followLiveRequested, this, &Temperature_Data_Display::followLive);
     startTime.setMSecsSinceEpoch(QDateTime::currentMSecsSinceEpoch());
     series = new QLineSeries();
-    series->append(QDateTime::currentMSecsSinceEpoch(), 0);
     series->setName("Temperature");
     x_Axis = new QDateTimeAxis();
     x_Axis->setFormat("h:mm:ss");
@@ -36,33 +51,732 @@ Temperature_Data_Display::Temperature_Data_Display(QWidget *parent) :
     ui->graphView->setChart(chart);
     ui->graphView->chart()->setAxisX(x_Axis, series);
     ui->graphView->chart()->setAxisY(y_Axis, series);
+    createFilteredSeries(filtered, tr("Filtered"));
+
+    if (!shm_Publisher.open())
+        qDebug() << "Shared memory sample ring unavailable:" << shm_Publisher.errorString();
+    restoreSession();
+
+    //The series is only a view of the visible range, rebuilt from history at most 10 times a second
+    connect(refresh_Timer, &QTimer::timeout, this, &Temperature_Data_Display::refreshChart);
+    refresh_Timer->start(100);
 }
 
 Temperature_Data_Display::~Temperature_Data_Display()
 {
+    //A QThread destroyed while running aborts the app, so a running export is stopped first
+    if (export_Thread) {
+        history_Exporter->cancel();
+        export_Thread->quit();
+        export_Thread->wait();
+        delete history_Exporter;
+    }
     delete ui;
 }
 
 void Temperature_Data_Display::grabData()
 {
-    char data[2];
-    uint16_t numberValue;
-    if(port->bytesAvailable() == 2 )
-    {
-        port->read(data, 2);
-        numberValue = (data[0] << 8) | data[1]; //Don't care
-        //Here we push it to our graph
-        qDebug() << "The value we got is " << numberValue/128;
-        series->append(QDateTime::currentMSecsSinceEpoch(), numberValue/128);
-        //chart->removeSeries(series);
-        //chart->addSeries(series);
-        //ui->graphView->chart()->setAxisX(x_Axis, series);
-        //ui->graphView->chart()->setAxisY(y_Axis, series);
-        x_Axis->setRange(startTime, QDateTime::currentDateTime().addSecs(1000));
-        //chartView->repaint();
+    //Stamp as close to the read as we can, from the monotonic clock
+    const qint64 readNs = sample_Clock.nowNs();
+
+    //read_Buffer keeps its capacity, so this only allocates when a read is bigger than any before
+    const int available = int(port->bytesAvailable());
+    read_Buffer.resize(available);
+    const qint64 got = port->read(read_Buffer.data(), available);
+    if (got > 0)
+        processBytes(read_Buffer.constData(), int(got), readNs);
+}
+
+//Both readers end up here with the bytes of one read and the time it was made
+void Temperature_Data_Display::processBytes(const char *data, int size, qint64 readNs)
+{
+    if (size <= 0)
+        return;
+    const qint64 startNs = sample_Clock.nowNs();
+
+    const uchar *bytes = reinterpret_cast<const uchar *>(data);
+    if (wire_Format == SettingsDialog::DeltaWire)
+        decodeDeltaFrames(bytes, size, readNs);
+    else if (wire_Format == SettingsDialog::TaggedWire)
+        decodeTaggedFrames(bytes, size, readNs);
+    else
+        decodeWords(bytes, size, readNs);
+
+    const qint64 doneNs = sample_Clock.nowNs();
+    rx_Bytes += quint64(size);
+    rx_DecodeNs += doneNs - startNs;
+    rx_LatencyNs += (double(doneNs - readNs) - rx_LatencyNs) / 16;
+
+    //Whole batches through the filters, once per read rather than once per reading
+    filterPending(filtered);
+    for (SensorTrack &track : sensor_Tracks)
+        filterPending(track.filtered);
+}
+
+void Temperature_Data_Display::decodeWords(const uchar *bytes, int size, qint64 readNs)
+{
+    //The bytes of a frame travel back to back, so bytes left over from a read long ago
+    //mean the rest was lost. Drop them and line up on the next frame again.
+    if (!rx_Buffer.isEmpty() && readNs - rx_LastNs > 50000000)
+        rx_Buffer.resize(0);
+    rx_LastNs = readNs;
+
+    //The buffers keep their capacity, one slot more for a frame finished from rx_Buffer
+    const int frameBytes = word_Codec->frameBytes();
+    word_Raw.resize(size / frameBytes + 1);
+    word_Values.resize(size / frameBytes + 1);
+    int frames = 0;
+
+    //Only a frame split across reads touches rx_Buffer: finish it there, then decode the
+    //rest straight from the caller's buffer
+    int offset = 0;
+    if (!rx_Buffer.isEmpty()) {
+        offset = qMin(frameBytes - rx_Buffer.size(), size);
+        rx_Buffer.append(reinterpret_cast<const char *>(bytes), offset);
+        if (rx_Buffer.size() < frameBytes)
+            return;
+        word_Codec->decode(reinterpret_cast<const uchar *>(rx_Buffer.constData()), frameBytes,
+                           word_Raw.data(), word_Values.data(), frames);
+        rx_Buffer.resize(0);
+    }
+    int count = 0;
+    const int used = offset + word_Codec->decode(bytes + offset, size - offset, word_Raw.data() + frames,
+                                                 word_Values.data() + frames, count);
+    frames += count;
+    rx_Buffer.append(reinterpret_cast<const char *>(bytes) + used, size - used);
+
+    //Frames that pile up between reads arrived over a stretch of time. Spread them back from
+    //the read at the sample period (at least their time on the wire) rather than give them one stamp.
+    const qint64 spacing = qMax(frameBytes * byte_WireNs, link_Clock.isValid() ? qint64(link_Clock.nsPerCount()) : qint64(0));
+    for (int k = 0; k < frames; k++) {
+        const qint64 timeNs = qMax(readNs - (frames - 1 - k) * spacing, last_SampleNs + 1);
+        last_SampleNs = timeNs;
+        ingestSample(timeNs, word_Raw.at(k), word_Values.at(k));
+    }
+
+    //In report on change mode frames are not evenly spaced readings, so there is no period to fit
+    if (frames > 0 && !report_OnChange) {
+        //Only the newest frame's arrival is known well, that is the one the link fit gets
+        frame_Index += frames;
+        link_Clock.observe(frame_Index - 1, readNs);
+    }
+}
+
+void Temperature_Data_Display::decodeDeltaFrames(const uchar *bytes, int size, qint64 readNs)
+{
+    //Collect the readings of this read first, the newest one's counter anchors the link fit
+    wire_Readings.resize(0);
+    delta_Decoder.feed(bytes, size, [this](quint16 counter, const quint16 *readings, int count) {
+        const qint64 first = unwrapCounter(counter, count);
+        for (int k = 0; k < count; k++)
+            wire_Readings.append(WireReading{first + k, readings[k], -1});
+    });
+    ingestWireReadings(readNs, byte_WireNs / 2);
+}
+
+void Temperature_Data_Display::decodeTaggedFrames(const uchar *bytes, int size, qint64 readNs)
+{
+    wire_Readings.resize(0);
+    tagged_Decoder.feed(bytes, size, [this](quint16 counter, const quint8 *sensors,
+                                            const quint16 *readings, int count) {
+        const qint64 first = unwrapCounter(counter, count);
+        for (int k = 0; k < count; k++)
+            wire_Readings.append(WireReading{first + k, readings[k], sensors[k]});
+    });
+    //One counter numbers the readings of every sensor, so the link fit works just as for delta frames
+    ingestWireReadings(readNs, TaggedFrame::SampleBytes * byte_WireNs);
+}
+
+//The counter is 16 bits on the wire, carry on from where the last frame ended
+qint64 Temperature_Data_Display::unwrapCounter(quint16 counter, int count)
+{
+    const qint64 first = device_CounterValid
+            ? device_NextCounter + qint16(quint16(counter - quint16(device_NextCounter))) : qint64(counter);
+    if (device_CounterValid && first > device_NextCounter)
+        lost_Readings += first - device_NextCounter;
+    device_NextCounter = first + count;
+    device_CounterValid = true;
+    return first;
+}
+
+void Temperature_Data_Display::ingestWireReadings(qint64 readNs, qint64 spacingNs)
+{
+    if (wire_Readings.isEmpty())
+        return;
+
+    //The board numbers its readings, so once the fit settles each one gets the time it was
+    //taken rather than the time it arrived. Until then assume they came back to back.
+    const qint64 newest = wire_Readings.last().counter;
+    link_Clock.observe(newest, readNs);
+    for (const WireReading &r : wire_Readings) {
+        qint64 timeNs = link_Clock.isValid() ? qMin(link_Clock.toHostNs(r.counter), readNs)
+                                             : readNs - (newest - r.counter) * spacingNs;
+        timeNs = qMax(timeNs, last_SampleNs + 1);
+        last_SampleNs = timeNs;
+        ingestSample(timeNs, r.raw, qint16(r.raw) / 128.0, r.sensor);
+    }
+}
+
+void Temperature_Data_Display::readerError(const QString &message)
+{
+    native_Port->close();
+    ui->status->setText(tr("Disconnected: %1").arg(message));
+}
+
+void Temperature_Data_Display::ingestSample(qint64 timeNs, quint32 raw, qreal celsius, int sensor)
+{
+    if (!restoring_Session) {
+        shm_Publisher.publish(quint32(qMax(sensor, 0)), timeNs, celsius, raw);
+        session_Journal.append(timeNs, raw, celsius, sensor);
     }
+    raw_Window.push(timeNs, celsius);
+
+    if (primary_Sensor < 0 && sensor >= 0) {
+        primary_Sensor = sensor;
+        series->setName(tr("Sensor 0x%1").arg(0x48 + sensor, 0, 16));
+        filtered.series->setName(tr("Sensor 0x%1 filtered").arg(0x48 + sensor, 0, 16));
+    }
+    if (sensor >= 0 && sensor != primary_Sensor) {
+        int t = 0;
+        while (t < sensor_Tracks.size() && sensor_Tracks[t].sensor != sensor)
+            t++;
+        if (t == sensor_Tracks.size()) {
+            //First reading from this sensor, give it a line of its own on the same axes
+            SensorTrack track;
+            track.sensor = sensor;
+            track.series = new QLineSeries();
+            track.series->setName(tr("Sensor 0x%1").arg(0x48 + sensor, 0, 16));
+            chart->addSeries(track.series);
+            chart->setAxisX(x_Axis, track.series);
+            chart->setAxisY(y_Axis, track.series);
+            track.series->setVisible(ui->actionShow_Raw->isChecked());
+            //Same filter settings as the first sensor, starting afresh
+            track.filtered.chain = filtered.chain;
+            track.filtered.chain.reset();
+            createFilteredSeries(track.filtered, tr("Sensor 0x%1 filtered").arg(0x48 + sensor, 0, 16));
+            sensor_Tracks.append(track);
+        }
+        sensor_Tracks[t].history.append(timeNs, celsius);
+        sensor_Tracks[t].rollups.append(timeNs, celsius);
+        queueFiltered(sensor_Tracks[t].filtered, timeNs, celsius);
+        chart_Dirty = true;
+        return;
+    }
+
+    history.append(timeNs, celsius);
+    queueFiltered(filtered, timeNs, celsius);
+    //The firmware stayed quiet because the reading didn't move, so the summaries get the held value,
+    //but only until the heartbeats stopped. Past that the board or link was down, which stays a gap.
+    if (report_OnChange && held_Valid)
+        rollups.hold(last_HeldNs, qMin(timeNs, last_HeldNs + hold_TimeoutNs), held_Value);
+    rollups.append(timeNs, celsius);
+    held_Valid = true;
+    held_Value = celsius;
+    last_HeldNs = timeNs;
+    //Here we let the graph know, it redraws on the next refresh
+    chart_Dirty = true;
+}
+
+//Puts the last few hours of the previous run back on the chart, before any port is open
+void Temperature_Data_Display::restoreSession()
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    if (dir.isEmpty() || !QDir().mkpath(dir) || !session_Journal.open(dir + QStringLiteral("/session.tgj"))) {
+        qDebug() << "Session journal unavailable:" << session_Journal.errorString();
+        return;
+    }
+
+    const qint64 nowNs = sample_Clock.nowNs();
+    restoring_Session = true;
+    quint64 restored = 0;
+    session_Journal.restore(nowNs - SessionRestoreNs, [this, nowNs, &restored](const SessionJournal::Record &r) {
+        //A wall clock that was ahead last run would leave readings in the future, drop those
+        if (r.timeNs > last_SampleNs && r.timeNs <= nowNs) {
+            ingestSample(r.timeNs, r.raw, r.celsius, r.sensor);
+            last_SampleNs = r.timeNs;
+            restored++;
+        }
+    });
+    restoring_Session = false;
+    if (history.isEmpty())
+        return;
+
+    filterPending(filtered);
+    for (SensorTrack &track : sensor_Tracks)
+        filterPending(track.filtered);
+    //The board wasn't listening during the restart, so nothing is held across it
+    held_Valid = false;
+    startTime.setMSecsSinceEpoch(history.firstTimeNs() / 1000000);
+    //Drawn by the first refresh, once the chart has a size
+    chart_Dirty = true;
+    ui->status->setText(tr("Restored %1 samples from the last session").arg(restored));
+}
+
+void Temperature_Data_Display::queueFiltered(FilteredTrack &track, qint64 timeNs, double celsius)
+{
+    if (track.chain.isEmpty())
+        return;
+    track.pendingNs.append(timeNs);
+    track.pendingValues.append(celsius);
+}
+
+void Temperature_Data_Display::filterPending(FilteredTrack &track)
+{
+    if (track.pendingNs.isEmpty())
+        return;
+    //pending keeps its capacity, so after the first few reads nothing here allocates
+    track.chain.process(track.pendingNs.constData(), track.pendingValues.data(), track.pendingValues.size());
+    for (int i = 0; i < track.pendingNs.size(); i++) {
+        track.history.append(track.pendingNs.at(i), track.pendingValues.at(i));
+        track.rollups.append(track.pendingNs.at(i), track.pendingValues.at(i));
+        track.window.push(track.pendingNs.at(i), track.pendingValues.at(i));
+    }
+    track.pendingNs.resize(0);
+    track.pendingValues.resize(0);
+    chart_Dirty = true;
+}
+
+void Temperature_Data_Display::createFilteredSeries(FilteredTrack &track, const QString &name)
+{
+    track.series = new QLineSeries();
+    track.series->setName(name);
+    chart->addSeries(track.series);
+    chart->setAxisX(x_Axis, track.series);
+    chart->setAxisY(y_Axis, track.series);
+    track.series->setVisible(ui->actionShow_Filtered->isChecked() && hasFiltered(track));
+}
+
+//Raw and filtered lines can each be hidden from the View menu, the data behind them is kept
+void Temperature_Data_Display::updateSeriesVisibility()
+{
+    const bool raw = ui->actionShow_Raw->isChecked();
+    const bool filter = ui->actionShow_Filtered->isChecked();
+    series->setVisible(raw);
+    filtered.series->setVisible(filter && hasFiltered(filtered));
+    for (SensorTrack &track : sensor_Tracks) {
+        track.series->setVisible(raw);
+        track.filtered.series->setVisible(filter && hasFiltered(track.filtered));
+    }
+    chart_Dirty = true;
+    refreshChart();
+}
+
+void Temperature_Data_Display::refreshChart()
+{
+    //A held reading grows towards now even when nothing arrives, redraw that once a second
+    const qint64 nowNs = sample_Clock.nowNs();
+    //The held line grows until the heartbeats stop, then is drawn once more to end where they did
+    const qint64 heldUntilNs = last_HeldNs + hold_TimeoutNs;
+    const bool held = report_OnChange && held_Valid && follow_Live && isConnected();
+    const bool holding = held && last_DrawNs <= heldUntilNs;
+    //A live span slides along with the clock, even when no reading arrived to move it
+    const bool sliding = follow_Live && live_SpanNs > 0 && isConnected();
+    if (!chart_Dirty && !((holding || sliding) && nowNs - last_DrawNs >= 1000000000LL))
+        return;
+    chart_Dirty = false;
+    last_DrawNs = nowNs;
+
+    if (follow_Live && live_SpanNs > 0) {
+        const QDateTime now = QDateTime::currentDateTime();
+        x_Axis->setRange(now.addMSecs(-live_SpanNs / 1000000), now);
+    } else if (follow_Live)
+        x_Axis->setRange(startTime, QDateTime::currentDateTime().addSecs(1000));
     else
-        port->readAll(); //Clear all data
+        x_Axis->setRange(QDateTime::fromMSecsSinceEpoch(view_FromMs), QDateTime::fromMSecsSinceEpoch(view_ToMs));
+    const qint64 fromNs = x_Axis->min().toMSecsSinceEpoch() * 1000000;
+    const qint64 toNs = x_Axis->max().toMSecsSinceEpoch() * 1000000;
+    const int pixels = qMax(1, int(chart->plotArea().width()));
+    if (ui->actionAutoscale_Y->isChecked())
+        autoscaleYAxis(fromNs, toNs, nowNs, held);
+
+    //Hidden lines are not rebuilt, updateSeriesVisibility() asks for a redraw when one is shown
+    for (SensorTrack &track : sensor_Tracks) {
+        if (track.series->isVisible()) {
+            buildChartPoints(track.history, track.rollups, fromNs, toNs, pixels);
+            track.series->replace(chart_Points);
+        }
+        if (track.filtered.series->isVisible()) {
+            buildChartPoints(track.filtered.history, track.filtered.rollups, fromNs, toNs, pixels);
+            track.filtered.series->replace(chart_Points);
+        }
+    }
+    if (filtered.series->isVisible()) {
+        buildChartPoints(filtered.history, filtered.rollups, fromNs, toNs, pixels);
+        filtered.series->replace(chart_Points);
+    }
+    if (series->isVisible()) {
+        buildChartPoints(history, rollups, fromNs, toNs, pixels);
+        if (held && !chart_Points.isEmpty() && nowNs > last_HeldNs)
+            chart_Points.append(QPointF(qMin(qMin(nowNs, heldUntilNs), toNs) / 1e6, held_Value));
+        series->replace(chart_Points);
+    }
+
+    QString message;
+    double low, high;
+    if (history.minMaxInRange(fromNs, toNs, low, high))
+        message = tr("Visible: min %1 C, max %2 C").arg(low, 0, 'f', 2).arg(high, 0, 'f', 2);
+    if (!sensor_Tracks.isEmpty())
+        message += tr(" (first of %1 sensors)").arg(sensor_Tracks.size() + 1);
+    if (link_Clock.isValid()) {
+        message += tr("   Link: period %1 ms").arg(link_Clock.nsPerCount() / 1e6, 0, 'f', 2);
+        if (link_Clock.referenceNsPerCount() > 0)
+            message += tr(", drift %1 ppm").arg(link_Clock.driftPpm(link_Clock.referenceNsPerCount()), 0, 'f', 1);
+        message += tr(", jitter %1 ms").arg(link_Clock.jitterNs() / 1e6, 0, 'f', 3);
+    }
+    if (wire_Format == SettingsDialog::DeltaWire && device_CounterValid)
+        message += tr("   Lost %1 readings, %2 bad frames").arg(lost_Readings).arg(delta_Decoder.badFrames());
+    if (wire_Format == SettingsDialog::TaggedWire && device_CounterValid)
+        message += tr("   Lost %1 readings, %2 bad frames").arg(lost_Readings).arg(tagged_Decoder.badFrames());
+    if (rx_Bytes > 0)
+        message += tr("   Read to decode %1 us, %2 ns/byte")
+                .arg(rx_LatencyNs / 1e3, 0, 'f', 1).arg(double(rx_DecodeNs) / rx_Bytes, 0, 'f', 1);
+    ui->statusBar->showMessage(message);
+}
+
+//Fits the Y axis to what is drawn between fromNs and toNs
+void Temperature_Data_Display::autoscaleYAxis(qint64 fromNs, qint64 toNs, qint64 nowNs, bool holding)
+{
+    bool any = false;
+    double low = 0, high = 0;
+    auto take = [&](double min, double max) {
+        low = any ? qMin(low, min) : min;
+        high = any ? qMax(high, max) : max;
+        any = true;
+    };
+    const bool raw = ui->actionShow_Raw->isChecked();
+
+    if (follow_Live) {
+        //The window only moves forward while following, the deques keep its bounds current
+        //raw_Window holds the raw readings of every sensor, one deque pair is enough for them
+        raw_Window.expire(fromNs);
+        if (raw && !raw_Window.isEmpty())
+            take(raw_Window.min(), raw_Window.max());
+        if (raw && holding)
+            take(held_Value, held_Value);
+        filtered.window.expire(fromNs);
+        if (filtered.series->isVisible() && !filtered.window.isEmpty())
+            take(filtered.window.min(), filtered.window.max());
+        for (SensorTrack &track : sensor_Tracks) {
+            track.filtered.window.expire(fromNs);
+            if (track.filtered.series->isVisible() && !track.filtered.window.isEmpty())
+                take(track.filtered.window.min(), track.filtered.window.max());
+        }
+    } else {
+        //A zoomed or panned view jumps about, ask the block index of each history instead
+        double min, max;
+        if (raw && history.minMaxInRange(fromNs, toNs, min, max))
+            take(min, max);
+        if (filtered.series->isVisible() && filtered.history.minMaxInRange(fromNs, toNs, min, max))
+            take(min, max);
+        for (const SensorTrack &track : sensor_Tracks) {
+            if (raw && track.history.minMaxInRange(fromNs, toNs, min, max))
+                take(min, max);
+            if (track.filtered.series->isVisible() && track.filtered.history.minMaxInRange(fromNs, toNs, min, max))
+                take(min, max);
+        }
+    }
+    double axisLow, axisHigh;
+    if (any && y_Scaler.update(low, high, nowNs, axisLow, axisHigh))
+        y_Axis->setRange(axisLow, axisHigh);
+}
+
+//Fills chart_Points with what samples has in fromNs..toNs, from summaries when that is too many points
+void Temperature_Data_Display::buildChartPoints(const CompressedHistory &samples, const RollupTiers &summaries,
+                                                qint64 fromNs, qint64 toNs, int pixels)
+{
+    //Pick the coarsest summaries that still give every pixel column its own min/max
+    chart_Points.clear();
+    const int tier = summaries.pickTier(fromNs, toNs, pixels);
+    if (tier == RollupTiers::RawTier) {
+        samples.forEachInRange(fromNs, toNs, [this](qint64 timeNs, double value) {
+            //Report on change: the previous reading held right up to this one, draw a step. Not past
+            //the missed heartbeats though, a dead link gets the plain line any other outage gets.
+            if (report_OnChange && !chart_Points.isEmpty()) {
+                const qreal heldToMs = qMin(timeNs / 1e6, chart_Points.last().x() + hold_TimeoutNs / 1e6);
+                chart_Points.append(QPointF(heldToMs, chart_Points.last().y()));
+            }
+            chart_Points.append(QPointF(timeNs / 1e6, value));
+        });
+    } else {
+        const qint64 halfWidth = summaries.tierWidthNs(tier) / 2;
+        summaries.buckets(tier, fromNs, toNs, chart_Buckets);
+        for (const RollupBucket &b : chart_Buckets) {
+            const qreal x = (b.startNs + halfWidth) / 1e6;
+            //Draw each bucket as a min-max stroke, starting from the end nearest the last point
+            const bool maxFirst = !chart_Points.isEmpty()
+                    && qAbs(chart_Points.last().y() - b.max) < qAbs(chart_Points.last().y() - b.min);
+            chart_Points.append(QPointF(x, maxFirst ? b.max : b.min));
+            if (b.max != b.min)
+                chart_Points.append(QPointF(x, maxFirst ? b.min : b.max));
+        }
+    }
+}
+
+void Temperature_Data_Display::setViewRange(qint64 fromMs, qint64 toMs)
+{
+    follow_Live = false;
+    view_FromMs = fromMs;
+    view_ToMs = toMs;
+    y_Scaler.reset();
+    //Redraw straight away rather than on the next tick so dragging stays smooth
+    chart_Dirty = true;
+    refreshChart();
+}
+
+void Temperature_Data_Display::followLive()
+{
+    follow_Live = true;
+    y_Scaler.reset();
+    chart_Dirty = true;
+    refreshChart();
+}
+
+void Temperature_Data_Display::setAutoscale(bool on)
+{
+    //Off goes back to the fixed range the chart always had
+    if (!on)
+        y_Axis->setRange(0, 100);
+    y_Scaler.reset();
+    chart_Dirty = true;
+    refreshChart();
+}
+
+void Temperature_Data_Display::chooseLiveSpan()
+{
+    const QStringList spans = QStringList() << tr("Since start") << tr("1 minute") << tr("10 minutes")
+                                            << tr("1 hour") << tr("1 day");
+    const qint64 spanSeconds[] = {0, 60, 600, 3600, 86400};
+    int current = 0;
+    for (int i = 0; i < spans.size(); i++) {
+        if (spanSeconds[i] * 1000000000LL == live_SpanNs)
+            current = i;
+    }
+    bool ok = false;
+    const QString span = QInputDialog::getItem(this, tr("Live Span"), tr("Following live shows:"),
+                                               spans, current, false, &ok);
+    if (!ok)
+        return;
+    live_SpanNs = spanSeconds[spans.indexOf(span)] * 1000000000LL;
+    followLive();
+}
+
+void Temperature_Data_Display::chooseAutoscalePadding()
+{
+    bool ok = false;
+    const double percent = QInputDialog::getDouble(this, tr("Autoscale Padding"),
+                                                   tr("Space above and below the readings, % of their range:"),
+                                                   y_Scaler.padding() * 100, 0, 100, 0, &ok);
+    if (!ok)
+        return;
+    y_Scaler.setPadding(percent / 100);
+    y_Scaler.reset();
+    chart_Dirty = true;
+    refreshChart();
+}
+
+void Temperature_Data_Display::saveHistory()
+{
+    const QString fileName = QFileDialog::getSaveFileName(this, tr("Save History"), QString(),
+                                                          tr("Temperature history (*.tgh)"));
+    if (fileName.isEmpty())
+        return;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || !history.save(&file) || !file.commit())
+        QMessageBox::critical(this, tr("Error"), tr("Could not save %1: %2").arg(fileName).arg(file.errorString()));
+}
+
+void Temperature_Data_Display::loadHistory()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("Load History"), QString(),
+                                                          tr("Temperature history (*.tgh)"));
+    if (fileName.isEmpty())
+        return;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly) || !history.load(&file)) {
+        QMessageBox::critical(this, tr("Error"), tr("%1 is not a temperature history file").arg(fileName));
+        return;
+    }
+
+    //Rebuild the summaries for what we loaded, new samples carry on after it
+    rollups.clear();
+    raw_Window.clear();
+    for (const CompressedBlock &block : history.blocks())
+        history.decodeBlock(block, [this](qint64 timeNs, double value) {
+            rollups.append(timeNs, value);
+            raw_Window.push(timeNs, value);
+        });
+    y_Scaler.reset();
+    if (!history.isEmpty())
+        startTime.setMSecsSinceEpoch(history.firstTimeNs() / 1000000);
+    chart_Dirty = true;
+    refreshChart();
+    ui->status->setText(tr("Loaded %1 samples (%2 KiB compressed)")
+                        .arg(history.count()).arg(history.byteSize() / 1024));
+}
+
+void Temperature_Data_Display::exportHistory()
+{
+    if (history.isEmpty()) {
+        QMessageBox::information(this, tr("Export"), tr("There is no history to export yet"));
+        return;
+    }
+
+    const QStringList ranges = QStringList() << tr("Visible range") << tr("Entire history");
+    bool ok = false;
+    const QString range = QInputDialog::getItem(this, tr("Export"), tr("Time range:"), ranges, 0, false, &ok);
+    if (!ok)
+        return;
+
+    //Tagged frames keep a history per sensor, an export holds one of them
+    const CompressedHistory *source = &history;
+    if (!sensor_Tracks.isEmpty()) {
+        QStringList sensors;
+        sensors << tr("Sensor 0x%1").arg(0x48 + primary_Sensor, 0, 16);
+        for (const SensorTrack &track : sensor_Tracks)
+            sensors << tr("Sensor 0x%1").arg(0x48 + track.sensor, 0, 16);
+        const QString sensor = QInputDialog::getItem(this, tr("Export"), tr("Sensor:"), sensors, 0, false, &ok);
+        if (!ok)
+            return;
+        const int index = sensors.indexOf(sensor);
+        if (index > 0)
+            source = &sensor_Tracks.at(index - 1).history;
+    }
+
+    const QString csvFilter = tr("CSV (*.csv)");
+    const QString columnarFilter = tr("Columnar binary (*.tgc)");
+    QString filter;
+    const QString fileName = QFileDialog::getSaveFileName(this, tr("Export History"), QString(),
+                                                          csvFilter + ";;" + columnarFilter, &filter);
+    if (fileName.isEmpty())
+        return;
+
+    qint64 fromNs = source->firstTimeNs();
+    qint64 toNs = source->lastTimeNs();
+    if (range == ranges.first()) {
+        fromNs = x_Axis->min().toMSecsSinceEpoch() * 1000000;
+        toNs = x_Axis->max().toMSecsSinceEpoch() * 1000000;
+    }
+    const HistoryExporter::Format format = (filter == columnarFilter || fileName.endsWith(".tgc"))
+            ? HistoryExporter::Columnar : HistoryExporter::Csv;
+
+    //The exporter decodes its own snapshot of the blocks, so new samples keep arriving meanwhile.
+    //One export at a time, the window has to be able to stop it when it closes.
+    QThread *thread = new QThread(this);
+    HistoryExporter *exporter = new HistoryExporter(*source, source->blocks(), fromNs, toNs, fileName, format);
+    exporter->moveToThread(thread);
+
+    QProgressDialog *progress = new QProgressDialog(tr("Exporting %1").arg(fileName), tr("Cancel"), 0, 100, this);
+    progress->setAttribute(Qt::WA_DeleteOnClose);
+    progress->setMinimumDuration(500);
+
+    connect(thread, &QThread::started, exporter, &HistoryExporter::run);
+    connect(exporter, &HistoryExporter::progress, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, progress, [exporter]() { exporter->cancel(); });
+    connect(exporter, &HistoryExporter::finished, this, [this, progress](bool ok, const QString &message) {
+        progress->close();
+        ui->statusBar->showMessage(message, 10000);
+        if (!ok)
+            QMessageBox::warning(this, tr("Export"), message);
+    });
+    connect(exporter, &HistoryExporter::finished, thread, &QThread::quit);
+    //Deleted from here rather than with deleteLater, so the destructor never races the worker
+    connect(thread, &QThread::finished, this, [this]() {
+        delete history_Exporter;
+        history_Exporter = nullptr;
+        export_Thread->deleteLater();
+        export_Thread = nullptr;
+        ui->actionExport_History->setEnabled(true);
+    });
+    export_Thread = thread;
+    history_Exporter = exporter;
+    ui->actionExport_History->setEnabled(false);
+    thread->start();
+}
+
+void Temperature_Data_Display::analyzeCapture()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("Analyze Capture"), QString(),
+                                                          tr("Columnar binary (*.tgc)"));
+    if (fileName.isEmpty() || !chooseAnalysisOptions())
+        return;
+
+    if (!capture_Analyzer) {
+        analysis_Text = new QPlainTextEdit;
+        analysis_Text->setReadOnly(true);
+        analysis_Text->setLineWrapMode(QPlainTextEdit::NoWrap);
+        analysis_Text->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+        QToolBar *toolBar = new QToolBar;
+        analysis_Cancel = toolBar->addAction(tr("Cancel"));
+        analysis_Cancel->setEnabled(false);
+        QWidget *panel = new QWidget;
+        QVBoxLayout *layout = new QVBoxLayout(panel);
+        layout->setContentsMargins(0, 0, 0, 0);
+        layout->addWidget(toolBar);
+        layout->addWidget(analysis_Text);
+        analysis_Dock = new QDockWidget(this);
+        analysis_Dock->setWidget(panel);
+        addDockWidget(Qt::RightDockWidgetArea, analysis_Dock);
+
+        //The report is redrawn as units come in, the analyzer keeps that to 10 times a second
+        capture_Analyzer = new CaptureAnalyzer(this);
+        connect(capture_Analyzer, &CaptureAnalyzer::updated, this, [this](int done, int total) {
+            analysis_Text->setPlainText(capture_Analyzer->report().toText(500));
+            ui->statusBar->showMessage(tr("Analysing: %1 of %2 units").arg(done).arg(total));
+        });
+        connect(capture_Analyzer, &CaptureAnalyzer::finished, this, [this](bool, const QString &message) {
+            analysis_Cancel->setEnabled(false);
+            ui->actionAnalyze_Capture->setEnabled(true);
+            ui->statusBar->showMessage(message, 10000);
+        });
+        connect(analysis_Cancel, &QAction::triggered, capture_Analyzer, &CaptureAnalyzer::cancel);
+    }
+
+    analysis_Dock->setWindowTitle(tr("Analysis of %1").arg(QFileInfo(fileName).fileName()));
+    analysis_Text->clear();
+    analysis_Dock->show();
+    if (capture_Analyzer->start(fileName, analysis_Options)) {
+        //One run at a time, the next waits for finished()
+        analysis_Cancel->setEnabled(true);
+        ui->actionAnalyze_Capture->setEnabled(false);
+    } else {
+        QMessageBox::critical(this, tr("Error"), tr("Could not analyse %1: %2").arg(fileName).arg(capture_Analyzer->errorString()));
+    }
+}
+
+bool Temperature_Data_Display::chooseAnalysisOptions()
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Analysis Options"));
+    QFormLayout *form = new QFormLayout(&dialog);
+    auto addSpin = [&](const QString &label, double value, double min, double max, int decimals, const QString &suffix) {
+        QDoubleSpinBox *spin = new QDoubleSpinBox(&dialog);
+        spin->setRange(min, max);
+        spin->setDecimals(decimals);
+        spin->setSuffix(suffix);
+        spin->setValue(value);
+        form->addRow(label, spin);
+        return spin;
+    };
+    QDoubleSpinBox *interval = addSpin(tr("Stats interval:"), analysis_Options.intervalNs / 1e9, 0.001, 86400, 3, tr(" s"));
+    QDoubleSpinBox *low = addSpin(tr("Low threshold:"), analysis_Options.lowThreshold, -40, 150, 2, tr(" C"));
+    QDoubleSpinBox *high = addSpin(tr("High threshold:"), analysis_Options.highThreshold, -40, 150, 2, tr(" C"));
+    QDoubleSpinBox *gap = addSpin(tr("Gap longer than:"), analysis_Options.gapNs / 1e9, 0.001, 86400, 3, tr(" s"));
+    QDoubleSpinBox *bin = addSpin(tr("Histogram bin:"), analysis_Options.binWidth, 0.0078125, 10, 4, tr(" C"));
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    form->addRow(buttons);
+    if (dialog.exec() != QDialog::Accepted)
+        return false;
+
+    analysis_Options.intervalNs = qint64(interval->value() * 1e9);
+    analysis_Options.lowThreshold = low->value();
+    analysis_Options.highThreshold = high->value();
+    analysis_Options.gapNs = qint64(gap->value() * 1e9);
+    analysis_Options.binWidth = bin->value();
+    return true;
 }
 
 void Temperature_Data_Display::openSerialPort()
@@ -76,18 +790,64 @@ void Temperature_Data_Display::openSerialPort()
     port->setParity(p.parity);
     port->setStopBits(p.stopBits);
     port->setFlowControl(p.flowControl);
-    if (port->open(QIODevice::ReadWrite)) {
+    //Start bit, data bits, parity bit and stop bits
+    const int bitsPerByte = 1 + int(p.dataBits) + (p.parity == QSerialPort::NoParity ? 0 : 1)
+            + (p.stopBits == QSerialPort::TwoStop ? 2 : 1);
+    if (p.baudRate > 0)
+        byte_WireNs = bitsPerByte * 1000000000LL / p.baudRate;
+    link_Clock.reset();
+    wire_Format = p.wireFormat;
+    word_Codec = &FrameCodecRegistry::codec(p.codec);
+    delta_Decoder.reset();
+    tagged_Decoder.reset();
+    //Filters start again on the new connection, what they already produced stays
+    filtered.chain.configure(p.medianWindow, p.lowPassSeconds, p.kalmanDrift);
+    for (SensorTrack &track : sensor_Tracks)
+        track.filtered.chain = filtered.chain;
+    updateSeriesVisibility();
+    device_CounterValid = false;
+    lost_Readings = 0;
+    //Delta frames carry every reading, the firmware only does report on change with 16 bit readings
+    report_OnChange = p.reportOnChange && p.wireFormat == SettingsDialog::WordWire;
+    hold_TimeoutNs = 3 * qint64(p.heartbeatMs) * 1000000;
+    held_Valid = false;
+    rx_Buffer.resize(0);
+    rx_Bytes = 0;
+    rx_DecodeNs = 0;
+    rx_LatencyNs = 0;
+
+    //Only one reader owns the device at a time
+    if (port->isOpen())
+        port->close();
+    native_Port->close();
+
+    bool opened;
+    QString error;
+    if (p.reader == SettingsDialog::QtSerialPortReader) {
+        opened = port->open(QIODevice::ReadWrite);
+        if (opened)
+            port->clear();
+        else
+            error = port->errorString();
+    } else {
+        opened = native_Port->open(p, p.reader == SettingsDialog::NativeLowLatencyReader);
+        error = native_Port->errorString();
+    }
+
+    if (opened) {
+        QString reader = p.stringReader;
+        if (p.reader == SettingsDialog::NativeLowLatencyReader && !native_Port->lowLatencyApplied())
+            reader += tr(" (driver ignored low latency)");
         QMessageBox box;
-        box.setText(tr("Connected to %1 : %2, %3, %4, %5, %6")
+        box.setText(tr("Connected to %1 : %2, %3, %4, %5, %6, %7")
                           .arg(p.name).arg(p.stringBaudRate).arg(p.stringDataBits)
-                          .arg(p.stringParity).arg(p.stringStopBits).arg(p.stringFlowControl));
+                          .arg(p.stringParity).arg(p.stringStopBits).arg(p.stringFlowControl).arg(reader));
         box.exec();
-        ui->status->setText((tr("Connected to %1 : %2, %3, %4, %5, %6")
+        ui->status->setText((tr("Connected to %1 : %2, %3, %4, %5, %6, %7")
                                   .arg(p.name).arg(p.stringBaudRate).arg(p.stringDataBits)
-                                  .arg(p.stringParity).arg(p.stringStopBits).arg(p.stringFlowControl)));
-        port->clear();
+                                  .arg(p.stringParity).arg(p.stringStopBits).arg(p.stringFlowControl).arg(reader)));
     } else {
-        QMessageBox::critical(this, tr("Error"), port->errorString());
+        QMessageBox::critical(this, tr("Error"), error);
     }
 }
 
@@ -97,6 +857,7 @@ void Temperature_Data_Display::closeSerialPort()
 
     if (port->isOpen())
         port->close();
+    native_Port->close();
     QMessageBox box;
     box.setText(tr("Disconnected"));
     box.exec();
@@ -14,11 +14,25 @@
 
 //Adding file from preexisting files on local directory
 #include "settingsdialog.h" //Created by QT
+#include "sharedmemorypublisher.h"
+#include "sessionjournal.h"
+#include "compressedhistory.h"
+#include "rolluptiers.h"
+#include "historychartview.h"
+#include "sampleclock.h"
+#include "nativeserialport.h"
+#include "deltaframe.h"
+#include "taggedframe.h"
+#include "framecodec.h"
+#include "samplefilters.h"
+#include "axisautoscaler.h"
+#include "captureanalyzer.h"
 
 using namespace QtCharts;
 namespace Ui {
 class Temperature_Data_Display;
 }
+class HistoryExporter;
 
 class Temperature_Data_Display : public QMainWindow
 {
@@ -32,20 +46,132 @@ public slots:
     void openSerialPort();
     void closeSerialPort();
     void grabData();
+    void saveHistory();
+    void loadHistory();
+    void exportHistory();
+    void analyzeCapture();
+
+private slots:
+    void refreshChart();
+    void setViewRange(qint64 fromMs, qint64 toMs);
+    void followLive();
+    void updateSeriesVisibility();
+    void setAutoscale(bool on);
+    void chooseLiveSpan();
+    void chooseAutoscalePadding();
+    void processBytes(const char *data, int size, qint64 readNs);
+    void readerError(const QString &message);
 
 signals:
     void sendData(qreal);
 
 private:
+    void decodeWords(const uchar *bytes, int size, qint64 readNs);
+    void decodeDeltaFrames(const uchar *bytes, int size, qint64 readNs);
+    void decodeTaggedFrames(const uchar *bytes, int size, qint64 readNs);
+    qint64 unwrapCounter(quint16 counter, int count);
+    void ingestWireReadings(qint64 readNs, qint64 spacingNs);
+    //sensor is the tagged frame sensor number, -1 for the single sensor of the other formats
+    void ingestSample(qint64 timeNs, quint32 raw, qreal celsius, int sensor = -1);
+    void buildChartPoints(const CompressedHistory &samples, const RollupTiers &summaries,
+                          qint64 fromNs, qint64 toNs, int pixels);
+    void autoscaleYAxis(qint64 fromNs, qint64 toNs, qint64 nowNs, bool holding);
+    bool chooseAnalysisOptions();
+    void restoreSession();
+
+    //Filtered copy of one sensor's readings, kept next to the raw history. Readings wait in
+    //pending until the read they came in is decoded, then the chain runs over them in one go.
+    struct FilteredTrack {
+        FilterChain chain;
+        CompressedHistory history{CompressedHistory::Xor};  //Filtered values are off the 1/128 grid
+        RollupTiers rollups;
+        QLineSeries *series = nullptr;
+        SlidingMinMax window;   //Live view bounds, see raw_Window
+        QVector<qint64> pendingNs;
+        QVector<double> pendingValues;
+    };
+    void queueFiltered(FilteredTrack &track, qint64 timeNs, double celsius);
+    void filterPending(FilteredTrack &track);
+    void createFilteredSeries(FilteredTrack &track, const QString &name);
+    //Filtering now, or filtered before the filters were turned off
+    static bool hasFiltered(const FilteredTrack &track) { return !track.chain.isEmpty() || !track.history.isEmpty(); }
+    bool isConnected() const { return port->isOpen() || native_Port->isOpen(); }
+
     Ui::Temperature_Data_Display *ui;
     SettingsDialog* port_Settings;
     QSerialPort* port;
+    NativeSerialPort* native_Port; //Used instead of port when a native reader is picked in the settings
     QChart* chart;
     QChartView *chartView;
     QDateTimeAxis* x_Axis;
     QValueAxis* y_Axis;
     QLineSeries* series;
+    FilteredTrack filtered; //Filtered readings of the sensor drawn by series
     QDateTime startTime;
+    SharedMemoryPublisher shm_Publisher; //Lets local processes read samples straight from memory
+    SessionJournal session_Journal; //The recent samples on disk, put back on the chart at the next start
+    bool restoring_Session = false; //Replaying the journal, so don't publish or journal again
+    static const qint64 SessionRestoreNs = 6 * 3600 * 1000000000LL; //How much of the last run comes back, the journal holds more
+    CompressedHistory history; //Every sample we have seen, Gorilla compressed
+    RollupTiers rollups; //1 s / 1 min / 1 h summaries of history for drawing long ranges
+    QTimer* refresh_Timer;
+    bool chart_Dirty = true;
+    bool follow_Live = true; //Otherwise the user zoomed or panned to view_FromMs..view_ToMs
+    qint64 view_FromMs = 0;
+    qint64 view_ToMs = 0;
+    QVector<QPointF> chart_Points; //Reused between refreshes so redrawing doesn't allocate
+    QVector<RollupBucket> chart_Buckets;
+    qint64 live_SpanNs = 0; //Follow live shows this much before now, 0 = everything since startTime
+    SlidingMinMax raw_Window; //Min/max of every sensor's raw readings in the live view, kept as they arrive
+    AxisAutoscaler y_Scaler;
+    SampleClock sample_Clock; //Monotonic ns stamps, immune to wall clock steps
+    ClockReconciler link_Clock; //Frame number vs arrival time, gives the sample period and link jitter
+    QByteArray read_Buffer; //QSerialPort reads land here, reused between reads
+    QByteArray rx_Buffer; //Bytes read but not yet decoded (less than a frame)
+    qint64 rx_LastNs = 0;
+    qint64 frame_Index = 0;
+    qint64 byte_WireNs = 86805; //Time one byte spends on the wire, 8N1 at 115200 until connected
+    SettingsDialog::WireFormat wire_Format = SettingsDialog::WordWire;
+    const FrameCodec *word_Codec = &FrameCodecRegistry::codec(FrameCodecRegistry::Adt7420);
+    QVector<quint32> word_Raw; //Readings of one read, reused
+    QVector<double> word_Values;
+    DeltaFrameDecoder delta_Decoder;
+    TaggedFrameDecoder tagged_Decoder;
+    struct WireReading { qint64 counter; quint16 raw; int sensor; };
+    QVector<WireReading> wire_Readings; //Readings of one read, reused
+    qint64 device_NextCounter = 0; //Delta frames number readings on the board, this is the next one due
+    bool device_CounterValid = false;
+    qint64 lost_Readings = 0;
+    qint64 last_SampleNs = 0;
+    //Tagged frames: the first sensor heard from is drawn by series, history and rollups above,
+    //every other one gets a track of its own
+    struct SensorTrack {
+        int sensor;
+        QLineSeries *series;
+        CompressedHistory history;
+        RollupTiers rollups;
+        FilteredTrack filtered;
+    };
+    QVector<SensorTrack> sensor_Tracks;
+    int primary_Sensor = -1;
+    bool report_OnChange = false; //Firmware deadband mode, readings hold until the next one arrives
+    bool held_Valid = false;
+    double held_Value = 0;
+    qint64 last_HeldNs = 0;
+    qint64 hold_TimeoutNs = 3000000000LL; //Three missed heartbeats, after that the link is taken as dead
+    qint64 last_DrawNs = 0;
+    quint64 rx_Bytes = 0; //Decoder cost, for comparing the readers
+    qint64 rx_DecodeNs = 0;
+    double rx_LatencyNs = 0; //Smoothed time from the read to the samples being in history
+    //The export in progress, stopped and waited for if the window closes first
+    QThread *export_Thread = nullptr;
+    HistoryExporter *history_Exporter = nullptr;
+    //Offline analysis of capture files, the dock is made the first time one is opened
+    AnalysisOptions analysis_Options;
+    CaptureAnalyzer *capture_Analyzer = nullptr;
+    QDockWidget *analysis_Dock = nullptr;
+    QPlainTextEdit *analysis_Text = nullptr;
+    QAction *analysis_Cancel = nullptr; //In the dock's toolbar, only enabled while an analysis runs
 };
 
 #endif // TEMPERATURE_DATA_DISPLAY_H
@@ -0,0 +1,365 @@
+/*
+ * Purpose: Stands in for the Vivado board on a Linux pseudo-terminal so the monitor can be
+ * load tested without hardware. Emits ADT7420 readings in the firmware's wire format
+ * (big endian 2 byte frames) with a drifting temperature, noise, and optional byte drops
+ * and bursts, at a fixed rate or as fast as the chosen baud rate allows. --deadband mimics
+ * the firmware's report on change mode, --format delta its delta frames (deltaframe.h).
+ *
+ * Point the monitor's custom device path at the printed slave (or the --link symlink).
+ * A once a second report on stderr shows what was sent.
+ *
+ * Build: qmake && make, or c++ -std=c++11 -O2 adt7420_sim.cpp -o adt7420_sim
+ * */
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    double rate = 10;           //samples per second, 0 = as fast as the baud rate allows
+    long baud = 115200;         //paces the output like the real UART would
+    int resolution = 16;        //13 or 16 bit ADT7420 mode
+    double start = 25.0;        //C
+    double drift = 0.01;        //C per second, turns around at low/high
+    double low = 15.0;
+    double high = 45.0;
+    double noise = 0.05;        //C, standard deviation
+    double dropRate = 0;        //probability that any one byte is lost
+    double burstRate = 0;       //probability per sample that a burst starts
+    int burstLength = 20;       //samples held back and then written at once
+    double seconds = 0;         //0 = run until interrupted
+    int deadband = -1;          //raw counts, like DEADBAND_COUNTS in main.c; -1 sends every sample
+    int heartbeatMs = 1000;     //longest gap between sends with a deadband, like HEARTBEAT_MS in main.c
+    bool delta = false;         //WIRE_DELTA frames instead of 2 bytes per sample
+    int frameReadings = 64;     //most readings in one delta frame
+    std::string link;
+};
+
+struct Stats {
+    unsigned long long samples = 0;
+    unsigned long long suppressed = 0;  //samples held back by the deadband
+    unsigned long long bytes = 0;
+    unsigned long long dropped = 0;
+    unsigned long long bursts = 0;
+    unsigned long long overruns = 0;    //bytes the pty would not take, nobody is reading
+};
+
+volatile sig_atomic_t running = 1;
+
+void stop(int)
+{
+    running = 0;
+}
+
+int64_t monotonicNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void sleepUntil(int64_t ns)
+{
+    timespec ts;
+    ts.tv_sec = ns / 1000000000LL;
+    ts.tv_nsec = ns % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR && running) {
+    }
+}
+
+//ADT7420 register layout: 16 bit mode is C * 128, 13 bit mode is C * 16 in bits 15..3
+uint16_t sensorCode(double celsius, int resolution)
+{
+    if (resolution == 13) {
+        long code = lround(celsius * 16);
+        code = code < -4096 ? -4096 : (code > 4095 ? 4095 : code);
+        return uint16_t(int16_t(code) << 3);
+    }
+    long code = lround(celsius * 128);
+    code = code < -32768 ? -32768 : (code > 32767 ? 32767 : code);
+    return uint16_t(int16_t(code));
+}
+
+void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --rate N          samples per second, 0 = as fast as the baud rate allows (10)\n"
+            "  --baud N          UART speed used to pace the output (115200)\n"
+            "  --resolution 13|16\n"
+            "  --start C         starting temperature (25)\n"
+            "  --drift C         drift per second, turns around at --low/--high (0.01)\n"
+            "  --low C --high C  drift limits (15, 45)\n"
+            "  --noise C         noise standard deviation (0.05)\n"
+            "  --drop P          probability of losing each byte (0)\n"
+            "  --burst P N       probability per sample of holding back N samples (0 20)\n"
+            "  --seconds S       stop after S seconds (run until interrupted)\n"
+            "  --deadband N      only send samples N raw counts away from the last one sent\n"
+            "  --heartbeat MS    with --deadband, send anyway after MS ms without a send (1000)\n"
+            "  --format raw|delta  2 byte samples or delta frames (raw)\n"
+            "  --frame N         most readings per delta frame, 1..64 (64)\n"
+            "  --link PATH       symlink PATH to the slave device\n",
+            argv0);
+    exit(2);
+}
+
+Options parse(int argc, char *argv[])
+{
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        const std::string a = argv[i];
+        auto next = [&]() -> const char * {
+            if (i + 1 >= argc)
+                usage(argv[0]);
+            return argv[++i];
+        };
+        if (a == "--rate") o.rate = atof(next());
+        else if (a == "--baud") o.baud = atol(next());
+        else if (a == "--resolution") o.resolution = atoi(next());
+        else if (a == "--start") o.start = atof(next());
+        else if (a == "--drift") o.drift = atof(next());
+        else if (a == "--low") o.low = atof(next());
+        else if (a == "--high") o.high = atof(next());
+        else if (a == "--noise") o.noise = atof(next());
+        else if (a == "--drop") o.dropRate = atof(next());
+        else if (a == "--burst") { o.burstRate = atof(next()); o.burstLength = atoi(next()); }
+        else if (a == "--seconds") o.seconds = atof(next());
+        else if (a == "--deadband") o.deadband = atoi(next());
+        else if (a == "--heartbeat") o.heartbeatMs = atoi(next());
+        else if (a == "--format") {
+            const std::string f = next();
+            if (f != "raw" && f != "delta")
+                usage(argv[0]);
+            o.delta = f == "delta";
+        }
+        else if (a == "--frame") o.frameReadings = atoi(next());
+        else if (a == "--link") o.link = next();
+        else usage(argv[0]);
+    }
+    if ((o.resolution != 13 && o.resolution != 16) || o.baud <= 0 || o.rate < 0 || o.burstLength < 1 || o.heartbeatMs < 1
+            || o.frameReadings < 1 || o.frameReadings > 64)
+        usage(argv[0]);
+    return o;
+}
+
+//Same frames as QueueDeltaReading() / SendDeltaFrame() in main.c
+class DeltaEncoder
+{
+public:
+    DeltaEncoder(int shift, int maxReadings) : m_shift(shift), m_max(maxReadings) {}
+
+    //Appends any frame this reading completes to out
+    void add(uint16_t reading, std::vector<unsigned char> &out)
+    {
+        const int delta = int16_t(uint16_t(reading - m_previous));
+        const int step = delta / (1 << m_shift);
+        if (m_count > 0 && step * (1 << m_shift) == delta && step >= -8 && step <= 7) {
+            const int slot = m_count - 1;
+            if (slot & 1)
+                m_frame[6 + slot / 2] |= uint8_t(step & 0x0F);
+            else
+                m_frame[6 + slot / 2] = uint8_t((step & 0x0F) << 4);
+            m_count++;
+        } else {
+            flush(out);
+            m_frame[2] = uint8_t(m_counter >> 8);
+            m_frame[3] = uint8_t(m_counter & 0xFF);
+            m_frame[4] = uint8_t(reading >> 8);
+            m_frame[5] = uint8_t(reading & 0xFF);
+            m_count = 1;
+        }
+        m_previous = reading;
+        m_counter++;
+        if (m_count == m_max)
+            flush(out);
+    }
+
+    void flush(std::vector<unsigned char> &out)
+    {
+        if (m_count == 0)
+            return;
+        const int length = 6 + m_count / 2;
+        m_frame[0] = 0xA5;
+        m_frame[1] = uint8_t(((m_count - 1) << 2) | m_shift);
+        uint8_t sum = 0;
+        for (int i = 1; i < length; i++)
+            sum = uint8_t(sum + m_frame[i]);
+        m_frame[length] = sum;
+        out.insert(out.end(), m_frame, m_frame + length + 1);
+        m_count = 0;
+    }
+
+    //Wire bytes per reading with full frames
+    static double bytesPerReading(int maxReadings) { return (7.0 + maxReadings / 2) / maxReadings; }
+
+private:
+    int m_shift;
+    int m_max;
+    int m_count = 0;
+    uint16_t m_previous = 0;
+    uint16_t m_counter = 0;
+    uint8_t m_frame[6 + 32 + 1];
+};
+
+int openPty(std::string &slaveName, int &slaveFd)
+{
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("posix_openpt");
+        exit(1);
+    }
+    slaveName = ptsname(master);
+
+    //Hold the slave open ourselves so the pty survives the monitor connecting and disconnecting,
+    //and put it in raw mode so nothing translates the binary frames
+    slaveFd = open(slaveName.c_str(), O_RDWR | O_NOCTTY);
+    if (slaveFd < 0) {
+        perror("open slave");
+        exit(1);
+    }
+    termios tio;
+    tcgetattr(slaveFd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slaveFd, TCSANOW, &tio);
+
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return master;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const Options o = parse(argc, argv);
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    std::string slaveName;
+    int slaveFd;
+    const int master = openPty(slaveName, slaveFd);
+    if (!o.link.empty()) {
+        unlink(o.link.c_str());
+        if (symlink(slaveName.c_str(), o.link.c_str()) != 0)
+            perror("symlink");
+    }
+    printf("%s\n", o.link.empty() ? slaveName.c_str() : o.link.c_str());
+    fflush(stdout);
+
+    //8N1: 10 bits per byte on the wire
+    const double maxRate = o.baud / 10.0 / (o.delta ? DeltaEncoder::bytesPerReading(o.frameReadings) : 2.0);
+    const double rate = (o.rate <= 0 || o.rate > maxRate) ? maxRate : o.rate;
+    const int64_t periodNs = int64_t(1e9 / rate);
+
+    std::mt19937_64 rng(std::random_device{}());
+    std::normal_distribution<double> noise(0, o.noise > 0 ? o.noise : 1e-12);
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    Stats stats, reported;
+    std::vector<unsigned char> out;
+    out.reserve(size_t(2 * (o.burstLength + 1) + 39));
+    std::vector<unsigned char> encoded;
+    DeltaEncoder encoder(o.resolution == 13 ? 3 : 0, o.frameReadings);
+    double temperature = o.start;
+    double drift = o.drift;
+    int held = 0;
+    uint16_t lastSent = 0;
+    bool sentAny = false;
+    int64_t lastSendNs = 0;
+
+    const int64_t begin = monotonicNs();
+    int64_t next = begin;
+    int64_t nextReport = begin + 1000000000LL;
+    while (running) {
+        next += periodNs;
+        sleepUntil(next);
+        const int64_t now = monotonicNs();
+        if (o.seconds > 0 && now - begin >= int64_t(o.seconds * 1e9))
+            break;
+
+        temperature += drift / rate;
+        if (temperature > o.high || temperature < o.low)
+            drift = -drift;
+        const uint16_t code = sensorCode(temperature + noise(rng), o.resolution);
+        stats.samples++;
+
+        //Same decision as ShouldSendReading() in main.c
+        bool send = true;
+        if (o.deadband >= 0 && !o.delta) {
+            const int delta = int16_t(code) - int16_t(lastSent);
+            if (sentAny && delta <= o.deadband && delta >= -o.deadband
+                    && now - lastSendNs < int64_t(o.heartbeatMs) * 1000000) {
+                stats.suppressed++;
+                send = false;
+            } else {
+                lastSent = code;
+                sentAny = true;
+                lastSendNs = now;
+            }
+        }
+
+        encoded.clear();
+        if (o.delta) {
+            encoder.add(code, encoded);
+        } else if (send) {
+            encoded.push_back(uint8_t(code >> 8));
+            encoded.push_back(uint8_t(code & 0xFF));
+        }
+        for (unsigned char byte : encoded) {
+            if (o.dropRate > 0 && uniform(rng) < o.dropRate)
+                stats.dropped++;
+            else
+                out.push_back(byte);
+        }
+
+        //A burst holds samples back, as a stalled board or a busy USB bridge would
+        if (held == 0 && o.burstRate > 0 && uniform(rng) < o.burstRate) {
+            held = o.burstLength;
+            stats.bursts++;
+        }
+        if (held > 0 && --held > 0)
+            continue;
+
+        size_t written = 0;
+        while (written < out.size()) {
+            const ssize_t n = write(master, out.data() + written, out.size() - written);
+            if (n <= 0)
+                break;
+            written += size_t(n);
+        }
+        stats.bytes += written;
+        stats.overruns += out.size() - written;
+        out.clear();
+
+        if (now >= nextReport) {
+            fprintf(stderr, "%llu samples/s, %llu held, %llu bytes/s, %llu dropped, %llu bursts, %llu overrun, %.3f C\n",
+                    stats.samples - reported.samples, stats.suppressed - reported.suppressed,
+                    stats.bytes - reported.bytes,
+                    stats.dropped - reported.dropped, stats.bursts - reported.bursts,
+                    stats.overruns - reported.overruns, temperature);
+            reported = stats;
+            nextReport += 1000000000LL;
+        }
+    }
+
+    fprintf(stderr, "sent %llu samples (%llu held), %llu bytes, %llu dropped, %llu bursts, %llu overrun\n",
+            stats.samples - stats.suppressed, stats.suppressed, stats.bytes, stats.dropped, stats.bursts, stats.overruns);
+    if (!o.link.empty())
+        unlink(o.link.c_str());
+    close(slaveFd);
+    close(master);
+    return 0;
+}
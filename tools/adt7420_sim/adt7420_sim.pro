@@ -0,0 +1,12 @@
+#-------------------------------------------------
+#
+# ADT7420 board simulator on a pseudo-terminal, for load testing the monitor
+#
+#-------------------------------------------------
+
+TEMPLATE = app
+TARGET = adt7420_sim
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+SOURCES += adt7420_sim.cpp
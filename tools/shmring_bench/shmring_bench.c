@@ -0,0 +1,201 @@
+/*
+ * Purpose: Measures how long it takes a local reader to see samples published into the
+ * shared-memory ring (sampleshmring.h), and what one read costs.
+ *
+ * Standalone mode (default) creates a private ring, runs a writer thread at --rate samples/s
+ * and --readers spinning reader threads for --seconds. Each reader reports the cost of
+ * ssr_read_latest() and the publish-to-observe latency (p50/p99/p99.9/max).
+ *
+ * --attach reads the ring of a running monitor instead, so only the read cost and the age
+ * of the samples it sees are reported.
+ *
+ * Build: qmake && make, or cc -O2 -pthread -I../.. shmring_bench.c -o shmring_bench -lrt
+ * */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "sampleshmring.h"
+
+#define MAX_READERS 64
+#define HIST_BUCKETS 4096 /* latency histogram, 64 ns per bucket up to ~262 us, last bucket is overflow */
+#define HIST_NS_PER_BUCKET 64
+
+typedef struct {
+    pthread_t thread;
+    const ssr_ring *ring;
+    uint64_t reads;
+    uint64_t observed;
+    uint64_t read_ns_total;
+    uint64_t hist[HIST_BUCKETS];
+    int64_t max_latency_ns;
+} reader_state;
+
+static volatile int running = 1;
+static double rate = 10000.0;
+static int readers = 1;
+static double seconds = 5.0;
+static const char *attach_name = NULL;
+
+static void *writer_main(void *arg)
+{
+    ssr_ring *ring = (ssr_ring *)arg;
+    const int64_t period = rate > 0 ? (int64_t)(1e9 / rate) : 0;
+    struct timespec next;
+    uint32_t code = 25 * 128;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (running) {
+        if (period) {
+            next.tv_nsec += period;
+            while (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
+        code += (uint32_t)(rand() % 3) - 1u;
+        ssr_publish(ring, 0, (int64_t)time(NULL) * 1000000000LL, code / 128.0, code);
+    }
+    return NULL;
+}
+
+static void *reader_main(void *arg)
+{
+    reader_state *st = (reader_state *)arg;
+    ssr_slot slot;
+    uint64_t last_index = UINT64_MAX;
+
+    while (running) {
+        const int64_t before = ssr_monotonic_ns();
+        const int got = ssr_read_latest(st->ring, &slot);
+        const int64_t after = ssr_monotonic_ns();
+        st->reads++;
+        st->read_ns_total += (uint64_t)(after - before);
+        if (!got || slot.index == last_index) {
+            //Let the writer run when readers outnumber the cores
+            sched_yield();
+            continue;
+        }
+
+        //First time we see this sample, how long after it was published?
+        last_index = slot.index;
+        st->observed++;
+        int64_t latency = before - slot.publish_ns;
+        if (latency < 0)
+            latency = 0;
+        if (latency > st->max_latency_ns)
+            st->max_latency_ns = latency;
+        uint64_t bucket = (uint64_t)latency / HIST_NS_PER_BUCKET;
+        st->hist[bucket < HIST_BUCKETS ? bucket : HIST_BUCKETS - 1]++;
+    }
+    return NULL;
+}
+
+static int64_t percentile(const uint64_t *hist, uint64_t total, double p)
+{
+    const uint64_t target = (uint64_t)(total * p);
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen > target)
+            return (int64_t)(i + 1) * HIST_NS_PER_BUCKET;
+    }
+    return (int64_t)HIST_BUCKETS * HIST_NS_PER_BUCKET;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [--rate N] [--readers N] [--seconds S] [--attach [NAME]]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rate") && i + 1 < argc)
+            rate = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--readers") && i + 1 < argc)
+            readers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--attach"))
+            attach_name = (i + 1 < argc && argv[i + 1][0] == '/') ? argv[++i] : SSR_DEFAULT_NAME;
+        else
+            usage(argv[0]);
+    }
+    if (readers < 1 || readers > MAX_READERS)
+        usage(argv[0]);
+
+    ssr_ring *ring;
+    pthread_t writer;
+    if (attach_name) {
+        const int fd = shm_open(attach_name, O_RDONLY, 0);
+        if (fd < 0) {
+            fprintf(stderr, "shm_open %s: %s\n", attach_name, strerror(errno));
+            return 1;
+        }
+        ssr_header header;
+        if (read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+            fprintf(stderr, "%s is too small to be a sample ring\n", attach_name);
+            return 1;
+        }
+        ring = mmap(NULL, ssr_ring_bytes(header.capacity), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (ring == MAP_FAILED || !ssr_is_valid(ring)) {
+            fprintf(stderr, "%s is not a sample ring this tool understands\n", attach_name);
+            return 1;
+        }
+    } else {
+        ring = mmap(NULL, ssr_ring_bytes(SSR_DEFAULT_CAPACITY), PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (ring == MAP_FAILED) {
+            perror("mmap");
+            return 1;
+        }
+        ssr_init(ring, SSR_DEFAULT_CAPACITY);
+        pthread_create(&writer, NULL, writer_main, ring);
+    }
+
+    reader_state *state = calloc((size_t)readers, sizeof(reader_state));
+    for (int i = 0; i < readers; i++) {
+        state[i].ring = ring;
+        pthread_create(&state[i].thread, NULL, reader_main, &state[i]);
+    }
+
+    usleep((useconds_t)(seconds * 1e6));
+    running = 0;
+    for (int i = 0; i < readers; i++)
+        pthread_join(state[i].thread, NULL);
+    if (!attach_name)
+        pthread_join(writer, NULL);
+
+    printf("%s, %d reader(s), %.1f s, %.0f samples/s published\n",
+           attach_name ? attach_name : "private ring", readers, seconds,
+           attach_name ? 0.0 : rate);
+    for (int i = 0; i < readers; i++) {
+        const reader_state *st = &state[i];
+        printf("reader %d: %llu reads, %.1f ns/read, %llu samples seen",
+               i, (unsigned long long)st->reads,
+               st->reads ? (double)st->read_ns_total / st->reads : 0.0,
+               (unsigned long long)st->observed);
+        if (st->observed)
+            printf(", %s p50 %lld ns, p99 %lld ns, p99.9 %lld ns, max %lld ns",
+                   attach_name ? "age" : "latency",
+                   (long long)percentile(st->hist, st->observed, 0.50),
+                   (long long)percentile(st->hist, st->observed, 0.99),
+                   (long long)percentile(st->hist, st->observed, 0.999),
+                   (long long)st->max_latency_ns);
+        printf("\n");
+    }
+    free(state);
+    return 0;
+}
@@ -0,0 +1,18 @@
+#-------------------------------------------------
+#
+# Reader latency benchmark for the shared-memory sample ring
+#
+#-------------------------------------------------
+
+TEMPLATE = app
+TARGET = shmring_bench
+CONFIG += console
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ../..
+QMAKE_CFLAGS += -std=gnu99
+LIBS += -lpthread -lrt
+
+SOURCES += shmring_bench.c
+
+HEADERS += ../../sampleshmring.h